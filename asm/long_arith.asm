@@ -0,0 +1,114 @@
+; long arithmetic routines of add.asm, sub.asm and mul.asm as SysV ABI
+; functions for linking into C and C++ code, see long_arith.h
+;    long numbers are little-endian arrays of qwords
+;    lengths may be zero
+
+                section         .text
+
+                global          asm_add_long_long
+                global          asm_sub_long_long
+                global          asm_mul_long_short
+                global          asm_div_long_short
+
+; adds two long numbers
+;    rdi -- address of summand #1 (long number)
+;    rsi -- address of summand #2 (long number)
+;    rdx -- length of long numbers in qwords
+; result:
+;    sum is written to rdi
+;    rax -- carry
+asm_add_long_long:
+                mov             rcx, rdx
+                xor             eax, eax
+                test            rcx, rcx
+                jz              .done
+.loop:
+                mov             rdx, [rsi]
+                lea             rsi, [rsi + 8]
+                adc             [rdi], rdx
+                lea             rdi, [rdi + 8]
+                dec             rcx
+                jnz             .loop
+
+                setc            al
+.done:
+                ret
+
+; subtracts two long numbers
+;    rdi -- address of minuend (long number)
+;    rsi -- address of subtrahend (long number)
+;    rdx -- length of long numbers in qwords
+; result:
+;    difference is written to rdi
+;    rax -- borrow
+asm_sub_long_long:
+                mov             rcx, rdx
+                xor             eax, eax
+                test            rcx, rcx
+                jz              .done
+.loop:
+                mov             rdx, [rsi]
+                lea             rsi, [rsi + 8]
+                sbb             [rdi], rdx
+                lea             rdi, [rdi + 8]
+                dec             rcx
+                jnz             .loop
+
+                setc            al
+.done:
+                ret
+
+; multiplies long number by a short
+;    rdi -- address of multiplier #1 (long number)
+;    rsi -- length of long number in qwords
+;    rdx -- multiplier #2 (64-bit unsigned)
+; result:
+;    product is written to rdi
+;    rax -- high qword of the product
+asm_mul_long_short:
+                mov             rcx, rsi
+                mov             r8, rdx
+                xor             esi, esi
+                test            rcx, rcx
+                jz              .done
+.loop:
+                mov             rax, [rdi]
+                mul             r8
+                add             rax, rsi
+                adc             rdx, 0
+                mov             [rdi], rax
+                add             rdi, 8
+                mov             rsi, rdx
+                dec             rcx
+                jnz             .loop
+.done:
+                mov             rax, rsi
+                ret
+
+; divides long number by a short
+;    rdi -- address of dividend (long number)
+;    rsi -- length of long number in qwords
+;    rdx -- divisor (64-bit unsigned, non-zero)
+; result:
+;    quotient is written to rdi
+;    rax -- remainder
+asm_div_long_short:
+                mov             rcx, rsi
+                mov             r8, rdx
+                xor             edx, edx
+                test            rcx, rcx
+                jz              .done
+
+                lea             rdi, [rdi + 8 * rcx - 8]
+.loop:
+                mov             rax, [rdi]
+                div             r8
+                mov             [rdi], rax
+                sub             rdi, 8
+                dec             rcx
+                jnz             .loop
+.done:
+                mov             rax, rdx
+                ret
+
+                section         .note.GNU-stack noalloc noexec nowrite progbits
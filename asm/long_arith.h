@@ -0,0 +1,29 @@
+#ifndef LONG_ARITH_H
+#define LONG_ARITH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Routines of long_arith.asm. Long numbers are little-endian arrays of n qwords. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* dst += src, returns the carry */
+uint64_t asm_add_long_long(uint64_t* dst, uint64_t const* src, size_t n);
+
+/* dst -= src, returns the borrow */
+uint64_t asm_sub_long_long(uint64_t* dst, uint64_t const* src, size_t n);
+
+/* dst *= m, returns the high qword of the product */
+uint64_t asm_mul_long_short(uint64_t* dst, size_t n, uint64_t m);
+
+/* dst /= d, returns the remainder; d must not be zero */
+uint64_t asm_div_long_short(uint64_t* dst, size_t n, uint64_t d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
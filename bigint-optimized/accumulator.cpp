@@ -0,0 +1,84 @@
+#include "accumulator.h"
+
+namespace {
+// Propagates the carries, leaving every word below 2^32.
+void normalize(std::vector<uint64_t>& words) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+        uint64_t curr = words[i] + carry;
+        words[i] = curr & UINT32_MAX;
+        carry = curr >> 32;
+    }
+    while (carry != 0) {
+        words.push_back(carry & UINT32_MAX);
+        carry >>= 32;
+    }
+}
+}
+
+big_integer_accumulator::big_integer_accumulator() : pending(0) {
+
+}
+
+big_integer_accumulator& big_integer_accumulator::operator+=(big_integer const& x) {
+    add(x, x.sign);
+    return *this;
+}
+
+big_integer_accumulator& big_integer_accumulator::operator-=(big_integer const& x) {
+    add(x, !x.sign);
+    return *this;
+}
+
+void big_integer_accumulator::add(big_integer const& x, bool is_negative) {
+    if (pending == MAX_PENDING) {
+        normalize(positive);
+        normalize(negative);
+        pending = 0;
+    }
+    pending++;
+    std::vector<uint64_t>& words = is_negative ? negative : positive;
+    size_t n = x.size();
+    if (words.size() < n) {
+        words.resize(n, 0);
+    }
+    uint32_t const* limbs = x.value.limbs();
+    uint64_t* w = words.data();
+    for (size_t i = 0; i < n; i++) {
+        w[i] += limbs[i];
+    }
+}
+
+big_integer big_integer_accumulator::result() const {
+    big_integer sums[2];
+    std::vector<uint64_t> const* words[2] = {&positive, &negative};
+    for (size_t k = 0; k < 2; k++) {
+        std::vector<uint64_t> const& w = *words[k];
+        if (w.empty()) {
+            continue;
+        }
+        buffer limbs(0);
+        limbs.resize_uninitialized(w.size() + 2);
+        uint32_t* r = limbs.mutable_limbs();
+        uint64_t carry = 0;
+        for (size_t i = 0; i < w.size(); i++) {
+            // below 2^64: the word has room for one more carry of up to 2^32
+            uint64_t curr = w[i] + carry;
+            r[i] = static_cast<uint32_t>(curr);
+            carry = curr >> 32;
+        }
+        r[w.size()] = static_cast<uint32_t>(carry);
+        r[w.size() + 1] = static_cast<uint32_t>(carry >> 32);
+        sums[k] = big_integer(limbs, false);
+        sums[k].delete_zero();
+    }
+    big_integer res;
+    sub(res, sums[0], sums[1]);
+    return res;
+}
+
+void big_integer_accumulator::clear() {
+    std::fill(positive.begin(), positive.end(), 0);
+    std::fill(negative.begin(), negative.end(), 0);
+    pending = 0;
+}
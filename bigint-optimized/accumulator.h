@@ -0,0 +1,35 @@
+#ifndef BIGINT_ACCUMULATOR_H
+#define BIGINT_ACCUMULATOR_H
+
+#include <cstdint>
+#include <vector>
+#include "big_integer.h"
+
+// Sum of many big integers without carry propagation per addition: every
+// 32-bit limb of an input is added into a 64-bit word, positive and negative
+// inputs into separate words. Carries are resolved once by result(), so a long
+// reduction is a single streaming pass that allocates only when the sum gets
+// wider than every input so far.
+struct big_integer_accumulator {
+    big_integer_accumulator();
+
+    big_integer_accumulator& operator+=(big_integer const& x);
+    big_integer_accumulator& operator-=(big_integer const& x);
+
+    big_integer result() const;
+
+    // Back to zero, keeping the words for reuse.
+    void clear();
+
+private:
+    void add(big_integer const& x, bool is_negative);
+
+    // A word holds the sum of up to this many limbs plus one carry without overflow.
+    static constexpr uint64_t MAX_PENDING = UINT32_MAX - 1;
+
+    std::vector<uint64_t> positive;
+    std::vector<uint64_t> negative;
+    uint64_t pending;
+};
+
+#endif //BIGINT_ACCUMULATOR_H
@@ -0,0 +1,102 @@
+// Limb block allocations and time per request for a temporary-heavy
+// computation, served by the global heap and by a per-request arena.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "big_integer.h"
+
+namespace {
+struct counting_allocator : limb_allocator {
+    explicit counting_allocator(limb_allocator& upstream) : upstream(upstream), allocations(0) {}
+
+    void* allocate(size_t bytes) override {
+        allocations++;
+        return upstream.allocate(bytes);
+    }
+
+    void deallocate(void* p, size_t bytes) override {
+        upstream.deallocate(p, bytes);
+    }
+
+    limb_allocator& upstream;
+    size_t allocations;
+};
+
+// Horner evaluation and a reduction, producing plenty of temporaries.
+big_integer handle_request(std::vector<big_integer> const& coeffs, big_integer const& x, big_integer const& m) {
+    big_integer acc;
+    for (size_t i = 0; i < coeffs.size(); i++) {
+        acc = acc * x + coeffs[i];
+    }
+    return acc % m + (acc >> 17) - (acc & m);
+}
+
+template <typename F>
+void run(char const* name, size_t requests, counting_allocator& counter, F&& f) {
+    counter.allocations = 0;
+    auto start = std::chrono::steady_clock::now();
+    size_t checksum = f();
+    auto finish = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count() / requests;
+    std::cout << name << ',' << ns << ',' << static_cast<double>(counter.allocations) / requests << ','
+              << checksum << '\n';
+}
+}
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    std::mt19937_64 rng(2020);
+    std::vector<big_integer> coeffs = big_integer::random_n(16, 32 * 4, rng);
+    big_integer x = big_integer::random(32 * 4, rng);
+    big_integer m = big_integer::random(32 * 8, rng) + 1;
+
+    counting_allocator counter(heap_allocator());
+    std::cout << "allocator,ns_per_request,allocations_per_request,checksum\n";
+    run("heap", requests, counter, [&] {
+        scoped_limb_allocator scope(counter);
+        size_t sum = 0;
+        for (size_t i = 0; i < requests; i++) {
+            sum += (handle_request(coeffs, x + i, m) != 0);
+        }
+        return sum;
+    });
+    run("arena", requests, counter, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < requests; i++) {
+            arena_allocator arena(64 * 1024, counter);
+            scoped_limb_allocator scope(arena);
+            sum += (handle_request(coeffs, x + i, m) != 0);
+        }
+        return sum;
+    });
+    run("arena_reset", requests, counter, [&] {
+        size_t sum = 0;
+        arena_allocator arena(64 * 1024, counter);
+        for (size_t i = 0; i < requests; i++) {
+            {
+                scoped_limb_allocator scope(arena);
+                sum += (handle_request(coeffs, x + i, m) != 0);
+            }
+            arena.reset();
+        }
+        return sum;
+    });
+    free_list_limb_allocator::trim();
+    run("free_lists", requests, counter, [&] {
+        scoped_limb_allocator scope(free_list_allocator());
+        size_t sum = 0;
+        for (size_t i = 0; i < requests; i++) {
+            sum += (handle_request(coeffs, x + i, m) != 0);
+        }
+        counter.allocations = free_list_limb_allocator::thread_stats().misses;
+        return sum;
+    });
+    free_list_stats stats = free_list_limb_allocator::thread_stats();
+    std::cerr << "free lists: hit rate " << static_cast<double>(stats.hits) / (stats.hits + stats.misses)
+              << ", retained bytes " << stats.retained_bytes << '\n';
+    return 0;
+}
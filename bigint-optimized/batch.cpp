@@ -0,0 +1,188 @@
+#include "batch.h"
+#include "accumulator.h"
+
+namespace {
+// Elements per range, enough to outweigh handing the range to a thread.
+const size_t GRAIN = 256;
+
+// Set while this thread runs ranges of a job. A batch call made from inside
+// a range runs inline: the job it would queue behind is the one calling it.
+thread_local bool in_job = false;
+
+struct in_job_scope {
+    in_job_scope() : outer(in_job) {
+        in_job = true;
+    }
+
+    ~in_job_scope() {
+        in_job = outer;
+    }
+
+private:
+    bool outer;
+};
+}
+
+batch_pool::batch_pool(size_t threads)
+    : stop(false), generation(0), active(0), job(nullptr), job_size(0), job_chunk(0), next(0) {
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(&batch_pool::work, this);
+    }
+}
+
+batch_pool::~batch_pool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+size_t batch_pool::threads() const {
+    return workers.size() + 1;
+}
+
+void batch_pool::run(size_t n, size_t grain, std::function<void(size_t, size_t)> const& f) {
+    grain = std::max<size_t>(grain, 1);
+    if (n == 0) {
+        return;
+    }
+    if (workers.empty() || n <= grain || in_job) {
+        f(0, n);
+        return;
+    }
+    std::lock_guard<std::mutex> serial(run_lock);
+    // a few ranges per thread even out ranges of unequal cost
+    size_t ranges = 4 * threads();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &f;
+        job_size = n;
+        job_chunk = std::max(grain, (n + ranges - 1) / ranges);
+        next.store(0, std::memory_order_relaxed);
+        active = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    {
+        in_job_scope scope;
+        work_on_job();
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [this] { return active == 0; });
+    job = nullptr;
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void batch_pool::work() {
+    in_job = true;
+    size_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this, seen] { return stop || generation != seen; });
+            if (stop) {
+                return;
+            }
+            seen = generation;
+        }
+        work_on_job();
+        std::lock_guard<std::mutex> guard(lock);
+        if (--active == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+void batch_pool::work_on_job() {
+    for (;;) {
+        size_t begin = next.fetch_add(job_chunk, std::memory_order_relaxed);
+        if (begin >= job_size) {
+            return;
+        }
+        try {
+            (*job)(begin, std::min(job_size, begin + job_chunk));
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!error) {
+                error = std::current_exception();
+            }
+            // the remaining ranges are dropped
+            next.store(job_size, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+batch_pool& default_batch_pool() {
+    static batch_pool pool;
+    return pool;
+}
+
+void add_n(big_integer* out, big_integer const* a, big_integer const* b, size_t n, batch_pool& pool) {
+    pool.run(n, GRAIN, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            add(out[i], a[i], b[i]);
+        }
+    });
+}
+
+void sub_n(big_integer* out, big_integer const* a, big_integer const* b, size_t n, batch_pool& pool) {
+    pool.run(n, GRAIN, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            sub(out[i], a[i], b[i]);
+        }
+    });
+}
+
+void mul_n(big_integer* out, big_integer const* a, big_integer const* b, size_t n, batch_pool& pool) {
+    pool.run(n, GRAIN, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            mul(out[i], a[i], b[i]);
+        }
+    });
+}
+
+void mul_scalar_n(big_integer* out, big_integer const* a, big_integer const& scalar, size_t n, batch_pool& pool) {
+    pool.run(n, GRAIN, [=, &scalar](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            mul(out[i], a[i], scalar);
+        }
+    });
+}
+
+void compare_n(int* out, big_integer const* a, big_integer const& scalar, size_t n, batch_pool& pool) {
+    pool.run(n, GRAIN, [=, &scalar](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            out[i] = compare(a[i], scalar);
+        }
+    });
+}
+
+big_integer sum(big_integer const* a, size_t n, batch_pool& pool) {
+    std::mutex partials_lock;
+    std::vector<big_integer> partials;
+    pool.run(n, GRAIN, [=, &partials_lock, &partials](size_t begin, size_t end) {
+        big_integer_accumulator acc;
+        for (size_t i = begin; i < end; i++) {
+            acc += a[i];
+        }
+        // the partial and every copy the vector makes of it are created and
+        // destroyed under the lock, their reference counts are not atomic
+        std::lock_guard<std::mutex> guard(partials_lock);
+        partials.push_back(acc.result());
+    });
+    big_integer res;
+    for (size_t i = 0; i < partials.size(); i++) {
+        add(res, res, partials[i]);
+    }
+    return res;
+}
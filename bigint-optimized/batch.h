@@ -0,0 +1,79 @@
+#ifndef BIGINT_BATCH_H
+#define BIGINT_BATCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "big_integer.h"
+
+// Fixed set of worker threads running index ranges of one job at a time;
+// the calling thread works on the job too.
+struct batch_pool {
+    // threads counts the caller, so 1 runs everything inline
+    explicit batch_pool(size_t threads = std::thread::hardware_concurrency());
+    ~batch_pool();
+
+    batch_pool(batch_pool const&) = delete;
+    batch_pool& operator=(batch_pool const&) = delete;
+
+    size_t threads() const;
+
+    // Calls f(begin, end) over disjoint ranges covering [0, n), each at least
+    // `grain` long except the last. Returns when all of them are done and
+    // rethrows the first exception f threw. Called from inside f, on this or
+    // any other pool, it runs f(0, n) inline on the calling thread instead.
+    void run(size_t n, size_t grain, std::function<void(size_t, size_t)> const& f);
+
+private:
+    void work();
+    void work_on_job();
+
+    std::vector<std::thread> workers;
+    std::mutex run_lock;   // one job at a time
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    bool stop;
+    size_t generation;
+    size_t active;         // workers still inside the current job
+
+    std::function<void(size_t, size_t)> const* job;
+    size_t job_size;
+    size_t job_chunk;
+    std::atomic<size_t> next;
+    std::exception_ptr error;
+};
+
+// Shared pool with one thread per core, created on first use.
+batch_pool& default_batch_pool();
+
+// Elementwise operations on arrays of n big integers: out[i] = a[i] op b[i].
+// Every out[i] keeps and reuses its limbs, so refilling the same output array
+// does not allocate once it has grown. Inputs are only read. Different out[i]
+// must not be copies of one another sharing limbs, unless reference counts are
+// atomic (BIGINT_ATOMIC_REFCOUNT). Workers allocate from their own
+// limb_allocator, not from the caller's scoped one.
+void add_n(big_integer* out, big_integer const* a, big_integer const* b, size_t n,
+           batch_pool& pool = default_batch_pool());
+void sub_n(big_integer* out, big_integer const* a, big_integer const* b, size_t n,
+           batch_pool& pool = default_batch_pool());
+void mul_n(big_integer* out, big_integer const* a, big_integer const* b, size_t n,
+           batch_pool& pool = default_batch_pool());
+
+// out[i] = a[i] * scalar
+void mul_scalar_n(big_integer* out, big_integer const* a, big_integer const& scalar, size_t n,
+                  batch_pool& pool = default_batch_pool());
+
+// out[i] = compare(a[i], scalar), i.e. -1, 0 or 1
+void compare_n(int* out, big_integer const* a, big_integer const& scalar, size_t n,
+               batch_pool& pool = default_batch_pool());
+
+// Sum of a[0, n): every worker adds up a contiguous range with a
+// big_integer_accumulator, then the partial sums are added together.
+big_integer sum(big_integer const* a, size_t n, batch_pool& pool = default_batch_pool());
+
+#endif //BIGINT_BATCH_H
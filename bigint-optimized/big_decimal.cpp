@@ -0,0 +1,279 @@
+#include "big_decimal.h"
+
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+// Powers of ten that fit in one limb.
+const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+const uint64_t POW10_MAX = 9;
+
+// What a rounding drops, relative to one unit of the last kept digit.
+enum class fraction {
+    zero,
+    below_half,
+    half,
+    above_half
+};
+
+int32_t checked_scale(int64_t scale) {
+    if (scale < std::numeric_limits<int32_t>::min() || scale > std::numeric_limits<int32_t>::max()) {
+        throw std::overflow_error("big_decimal scale out of range");
+    }
+    return static_cast<int32_t>(scale);
+}
+
+big_integer magnitude(big_integer const& a) {
+    return a < 0 ? -a : a;
+}
+
+// a *= 10^k
+void scale_up(big_integer& a, uint64_t k) {
+    for (; k >= POW10_MAX; k -= POW10_MAX) {
+        a *= POW10[POW10_MAX];
+    }
+    if (k != 0) {
+        a *= POW10[k];
+    }
+}
+
+// a /= 10^k for a >= 0 and k >= 1, returns the class of the dropped digits:
+// all but the last dropped digit only matter for being nonzero.
+fraction scale_down(big_integer& a, uint64_t k) {
+    bool sticky = false;
+    for (; k > POW10_MAX; k -= POW10_MAX) {
+        sticky = divrem(a, POW10[POW10_MAX]) != 0 || sticky;
+    }
+    // the last 1 to 9 dropped digits, the highest of them decides the rounding
+    uint64_t rest = divrem(a, POW10[k]);
+    uint64_t digit = rest / POW10[k - 1];
+    sticky = sticky || rest % POW10[k - 1] != 0;
+    if (digit == 0) {
+        return sticky ? fraction::below_half : fraction::zero;
+    }
+    if (digit == 5) {
+        return sticky ? fraction::above_half : fraction::half;
+    }
+    return digit < 5 ? fraction::below_half : fraction::above_half;
+}
+
+// Rounds the truncated magnitude q of a value with the given sign.
+void round(big_integer& q, bool negative, fraction dropped, rounding_mode mode) {
+    if (dropped == fraction::zero) {
+        return;
+    }
+    bool increment = false;
+    switch (mode) {
+        case rounding_mode::down:
+            break;
+        case rounding_mode::up:
+            increment = true;
+            break;
+        case rounding_mode::floor:
+            increment = negative;
+            break;
+        case rounding_mode::ceiling:
+            increment = !negative;
+            break;
+        case rounding_mode::half_up:
+            increment = dropped != fraction::below_half;
+            break;
+        case rounding_mode::half_down:
+            increment = dropped == fraction::above_half;
+            break;
+        case rounding_mode::half_even:
+            increment = dropped == fraction::above_half || (dropped == fraction::half && q % 2 != 0);
+            break;
+    }
+    if (increment) {
+        q += 1;
+    }
+}
+}
+
+big_decimal::big_decimal() : m(0), s(0) {
+
+}
+
+big_decimal::big_decimal(big_integer const& mantissa, int32_t scale) : m(mantissa), s(scale) {
+
+}
+
+big_decimal::big_decimal(std::string const& str) : m(0), s(0) {
+    size_t begin = (!str.empty() && (str[0] == '-' || str[0] == '+')) ? 1 : 0;
+    std::string digits;
+    digits.reserve(str.size());
+    size_t point = std::string::npos;
+    for (size_t i = begin; i < str.size(); i++) {
+        if (str[i] == '.' && point == std::string::npos) {
+            point = i;
+        } else if (str[i] >= '0' && str[i] <= '9') {
+            digits += str[i];
+        } else {
+            throw std::invalid_argument("invalid decimal string");
+        }
+    }
+    if (digits.empty()) {
+        throw std::invalid_argument("invalid decimal string");
+    }
+    m = big_integer(digits);
+    if (str[0] == '-') {
+        m = -m;
+    }
+    s = point == std::string::npos ? 0 : checked_scale(static_cast<int64_t>(str.size() - point - 1));
+}
+
+big_integer const& big_decimal::mantissa() const {
+    return m;
+}
+
+int32_t big_decimal::scale() const {
+    return s;
+}
+
+big_decimal big_decimal::rescale(int32_t scale, rounding_mode mode) const {
+    if (scale >= s) {
+        big_integer res = m;
+        scale_up(res, static_cast<int64_t>(scale) - s);
+        return big_decimal(res, scale);
+    }
+    bool negative = m < 0;
+    big_integer res = magnitude(m);
+    fraction dropped = scale_down(res, static_cast<int64_t>(s) - scale);
+    round(res, negative, dropped, mode);
+    return big_decimal(negative ? -res : res, scale);
+}
+
+big_decimal& big_decimal::operator+=(big_decimal const& rhs) {
+    if (s < rhs.s) {
+        scale_up(m, static_cast<int64_t>(rhs.s) - s);
+        s = rhs.s;
+    }
+    if (s == rhs.s) {
+        add(m, m, rhs.m);
+        return *this;
+    }
+    big_integer aligned = rhs.m;
+    scale_up(aligned, static_cast<int64_t>(s) - rhs.s);
+    add(m, m, aligned);
+    return *this;
+}
+
+big_decimal& big_decimal::operator-=(big_decimal const& rhs) {
+    if (s < rhs.s) {
+        scale_up(m, static_cast<int64_t>(rhs.s) - s);
+        s = rhs.s;
+    }
+    if (s == rhs.s) {
+        sub(m, m, rhs.m);
+        return *this;
+    }
+    big_integer aligned = rhs.m;
+    scale_up(aligned, static_cast<int64_t>(s) - rhs.s);
+    sub(m, m, aligned);
+    return *this;
+}
+
+big_decimal& big_decimal::operator*=(big_decimal const& rhs) {
+    *this = *this * rhs;
+    return *this;
+}
+
+big_decimal big_decimal::operator-() const {
+    return big_decimal(-m, s);
+}
+
+big_decimal operator+(big_decimal a, big_decimal const& b) {
+    return a += b;
+}
+
+big_decimal operator-(big_decimal a, big_decimal const& b) {
+    return a -= b;
+}
+
+big_decimal operator*(big_decimal const& a, big_decimal const& b) {
+    return big_decimal(a.m * b.m, checked_scale(static_cast<int64_t>(a.s) + b.s));
+}
+
+big_decimal div(big_decimal const& a, big_decimal const& b, int32_t scale, rounding_mode mode) {
+    if (b.m == 0) {
+        throw std::domain_error("big_decimal division by zero");
+    }
+    bool negative = (a.m < 0) != (b.m < 0);
+    big_integer n = magnitude(a.m);
+    big_integer d = magnitude(b.m);
+    // n / d * 10^(b.s - a.s) is the quotient, 10^scale times it the result mantissa
+    int64_t shift = static_cast<int64_t>(scale) - a.s + b.s;
+    if (shift >= 0) {
+        scale_up(n, shift);
+    } else {
+        scale_up(d, -shift);
+    }
+    big_integer q, r;
+    divrem(q, r, n, d);
+    fraction dropped = fraction::zero;
+    if (r != 0) {
+        int half = compare(r << 1, d);
+        dropped = half < 0 ? fraction::below_half : half == 0 ? fraction::half : fraction::above_half;
+    }
+    round(q, negative, dropped, mode);
+    return big_decimal(negative ? -q : q, scale);
+}
+
+int compare(big_decimal const& a, big_decimal const& b) {
+    if (a.s == b.s) {
+        return compare(a.m, b.m);
+    }
+    int sign_a = compare(a.m, 0);
+    int sign_b = compare(b.m, 0);
+    if (sign_a != sign_b) {
+        return sign_a < sign_b ? -1 : 1;
+    }
+    big_integer aligned = a.s < b.s ? a.m : b.m;
+    scale_up(aligned, a.s < b.s ? static_cast<int64_t>(b.s) - a.s : static_cast<int64_t>(a.s) - b.s);
+    return a.s < b.s ? compare(aligned, b.m) : compare(a.m, aligned);
+}
+
+bool operator==(big_decimal const& a, big_decimal const& b) {
+    return compare(a, b) == 0;
+}
+
+bool operator!=(big_decimal const& a, big_decimal const& b) {
+    return compare(a, b) != 0;
+}
+
+bool operator<(big_decimal const& a, big_decimal const& b) {
+    return compare(a, b) < 0;
+}
+
+bool operator>(big_decimal const& a, big_decimal const& b) {
+    return compare(a, b) > 0;
+}
+
+bool operator<=(big_decimal const& a, big_decimal const& b) {
+    return compare(a, b) <= 0;
+}
+
+bool operator>=(big_decimal const& a, big_decimal const& b) {
+    return compare(a, b) >= 0;
+}
+
+std::string to_string(big_decimal const& a) {
+    bool negative = a.m < 0;
+    std::string digits = to_string(magnitude(a.m));
+    if (a.s < 0 && a.m != 0) {
+        digits.append(static_cast<size_t>(-static_cast<int64_t>(a.s)), '0');
+    } else if (a.s > 0) {
+        size_t fraction_digits = static_cast<size_t>(a.s);
+        if (digits.size() <= fraction_digits) {
+            digits.insert(0, fraction_digits + 1 - digits.size(), '0');
+        }
+        digits.insert(digits.size() - fraction_digits, 1, '.');
+    }
+    return negative ? "-" + digits : digits;
+}
+
+std::ostream& operator<<(std::ostream& s, big_decimal const& a) {
+    return s << to_string(a);
+}
@@ -0,0 +1,73 @@
+#ifndef BIG_DECIMAL_H
+#define BIG_DECIMAL_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include "big_integer.h"
+
+// How digits dropped by rescale and div are rounded; the names follow
+// java.math.RoundingMode. down and up are towards and away from zero.
+enum class rounding_mode {
+    down,
+    up,
+    floor,
+    ceiling,
+    half_up,
+    half_down,
+    half_even
+};
+
+// Exact decimal fixed-point number: mantissa * 10^-scale. The scale is the
+// number of fraction digits and may be negative. +, - and * are exact, the
+// result of + and - has the larger scale of the operands, the one of * their
+// sum. Division and scale reduction round as asked.
+//
+// Scales are aligned by multiplying the mantissa with the cached powers of ten
+// that fit in one limb, so that every step is a single-limb pass.
+struct big_decimal {
+    big_decimal();
+    big_decimal(big_integer const& mantissa, int32_t scale = 0);
+    // [+-]digits[.digits], the scale is the number of digits after the point
+    explicit big_decimal(std::string const& str);
+
+    big_integer const& mantissa() const;
+    int32_t scale() const;
+
+    // The same value with `scale` fraction digits, rounded when digits are dropped.
+    big_decimal rescale(int32_t scale, rounding_mode mode = rounding_mode::half_even) const;
+
+    big_decimal& operator+=(big_decimal const& rhs);
+    big_decimal& operator-=(big_decimal const& rhs);
+    big_decimal& operator*=(big_decimal const& rhs);
+
+    big_decimal operator-() const;
+
+    friend big_decimal operator+(big_decimal a, big_decimal const& b);
+    friend big_decimal operator-(big_decimal a, big_decimal const& b);
+    friend big_decimal operator*(big_decimal const& a, big_decimal const& b);
+
+    friend big_decimal div(big_decimal const& a, big_decimal const& b, int32_t scale, rounding_mode mode);
+
+    // Values are compared, so 1.5 == 1.50.
+    friend int compare(big_decimal const& a, big_decimal const& b);
+    friend bool operator==(big_decimal const& a, big_decimal const& b);
+    friend bool operator!=(big_decimal const& a, big_decimal const& b);
+    friend bool operator<(big_decimal const& a, big_decimal const& b);
+    friend bool operator>(big_decimal const& a, big_decimal const& b);
+    friend bool operator<=(big_decimal const& a, big_decimal const& b);
+    friend bool operator>=(big_decimal const& a, big_decimal const& b);
+
+    friend std::string to_string(big_decimal const& a);
+    friend std::ostream& operator<<(std::ostream& s, big_decimal const& a);
+
+private:
+    big_integer m;
+    int32_t s;
+};
+
+// a / b with `scale` fraction digits; throws std::domain_error when b is zero.
+big_decimal div(big_decimal const& a, big_decimal const& b, int32_t scale,
+                rounding_mode mode = rounding_mode::half_even);
+
+#endif //BIG_DECIMAL_H
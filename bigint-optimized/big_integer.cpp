@@ -1,9 +1,69 @@
 #include "big_integer.h"
+#include "bitwise_kernels.h"
+#include "instrumentation.h"
+#include "limb_kernels.h"
+#include "probes.h"
+#include "tuning.h"
+
+#include <istream>
+#include <ostream>
 
 typedef unsigned long long int uint128_t __attribute__ ((mode (TI)));
 
-const uint64_t u32 = static_cast<uint64_t>(UINT32_MAX) + 1;
-const big_integer b32 = big_integer(UINT32_MAX) + 1;
+const uint32_t DECIMAL_CHUNK = 1000000000;
+const size_t DECIMAL_CHUNK_DIGITS = 9;
+const size_t DECIMAL_BLOCK_CHUNKS = 64;
+// Values of up to this many decimal chunks are converted by repeated single-limb
+// division, larger ones are split in halves by powers of 10^9 first.
+const size_t DECIMAL_SPLIT_CHUNKS = 384;
+// Reciprocals of up to this many bits come from one schoolbook division.
+const size_t RECIPROCAL_SCHOOLBOOK_BITS = 32 * 32;
+
+void write_decimal_chunk(char* out, uint32_t chunk) {
+    for (size_t i = DECIMAL_CHUNK_DIGITS; i > 0; i--) {
+        out[i - 1] = static_cast<char>('0' + chunk % 10);
+        chunk /= 10;
+    }
+}
+
+// Digits of the power-of-two bases; bases up to 32 are parsed case-insensitively.
+const char radix_digits[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ+/";
+
+int radix_bits(int base) {
+    switch (base) {
+        case 2:
+            return 1;
+        case 8:
+            return 3;
+        case 16:
+            return 4;
+        case 32:
+            return 5;
+        case 64:
+            return 6;
+        default:
+            throw std::invalid_argument("unsupported base");
+    }
+}
+
+int radix_digit(char c, int base) {
+    int digit = -1;
+    if (c >= '0' && c <= '9') {
+        digit = c - '0';
+    } else if (c >= 'a' && c <= 'z') {
+        digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'Z') {
+        digit = c - 'A' + (base <= 32 ? 10 : 36);
+    } else if (c == '+') {
+        digit = 62;
+    } else if (c == '/') {
+        digit = 63;
+    }
+    if (digit < 0 || digit >= base) {
+        throw std::invalid_argument("invalid digit");
+    }
+    return digit;
+}
 
 big_integer::big_integer() : value(0), sign(false) {
 
@@ -13,6 +73,10 @@ big_integer::big_integer(big_integer const& other) : value(other.value), sign(ot
 
 }
 
+big_integer::big_integer(buffer const& limbs, bool sign) : value(limbs), sign(sign) {
+
+}
+
 big_integer::big_integer(int a) : value(0), sign(a < 0) {
     if (a == std::numeric_limits<int>::min()) {
         value[0] = 2147483648;
@@ -33,12 +97,55 @@ big_integer::big_integer(std::string const& str) : value(0), sign(false) {
     if (str[0] == '-') {
         curr_pos = 1;
     }
+    instrumentation::record_op(bigint_op::from_string, (str.size() - curr_pos) / DECIMAL_CHUNK_DIGITS + 1);
+    BIGINT_PROBE1(from_string__entry, str.size());
     while (curr_pos < str.size()) {
-        *this *= 10;
-        *this += static_cast<uint32_t>(str[curr_pos] - 48);
-        curr_pos++;
+        uint32_t chunk = 0;
+        uint32_t chunk_pow = 1;
+        for (size_t i = 0; i < DECIMAL_CHUNK_DIGITS && curr_pos < str.size(); i++, curr_pos++) {
+            chunk = chunk * 10 + static_cast<uint32_t>(str[curr_pos] - 48);
+            chunk_pow *= 10;
+        }
+        mul_add(chunk_pow, chunk);
+    }
+    sign = (str[0] == '-') && !(size() == 1 && value[0] == 0);
+    BIGINT_PROBE1(from_string__return, size());
+}
+
+big_integer::big_integer(std::string const& str, int base) : value(0), sign(false) {
+    if (base == 10) {
+        *this = big_integer(str);
+        return;
+    }
+    int bits = radix_bits(base);
+    size_t begin = (!str.empty() && str[0] == '-') ? 1 : 0;
+    if (begin == str.size()) {
+        throw std::invalid_argument("invalid string");
+    }
+    size_t limbs = (str.size() - begin) * bits / 32 + 1;
+    instrumentation::record_op(bigint_op::from_string, limbs);
+    BIGINT_PROBE1(from_string__entry, str.size());
+    value.resize_uninitialized(limbs);
+    uint32_t* r = value.mutable_limbs();
+    size_t k = 0;
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    for (size_t i = str.size(); i > begin; i--) {
+        acc |= static_cast<uint64_t>(radix_digit(str[i - 1], base)) << acc_bits;
+        acc_bits += bits;
+        if (acc_bits >= 32) {
+            r[k++] = static_cast<uint32_t>(acc);
+            acc >>= 32;
+            acc_bits -= 32;
+        }
+    }
+    if (acc_bits > 0) {
+        r[k++] = static_cast<uint32_t>(acc);
     }
-    sign = (str[0] == '-');
+    std::fill(r + k, r + limbs, 0);
+    delete_zero();
+    sign = begin == 1 && !(size() == 1 && value[0] == 0);
+    BIGINT_PROBE1(from_string__return, size());
 }
 
 big_integer::~big_integer() = default;
@@ -52,6 +159,10 @@ big_integer& big_integer::operator=(big_integer const& other) {
     return *this;
 }
 
+big_integer big_integer::deep_copy() const {
+    return big_integer(value.clone(), sign);
+}
+
 big_integer& big_integer::operator+=(big_integer const& rhs) {
     *this = *this + rhs;
     return *this;
@@ -142,118 +253,262 @@ big_integer big_integer::operator--(int) {
 }
 
 big_integer operator+(big_integer a, big_integer const& b) {
+    big_integer res;
+    add(res, a, b);
+    return res;
+}
+
+big_integer operator-(big_integer a, big_integer const& b) {
+    big_integer res;
+    sub(res, a, b);
+    return res;
+}
+
+void add(big_integer& res, big_integer const& a, big_integer const& b) {
+    res.assign_sum(a, b, b.sign);
+}
+
+void sub(big_integer& res, big_integer const& a, big_integer const& b) {
+    res.assign_sum(a, b, !b.sign);
+}
+
+int compare(big_integer const& a, big_integer const& b) {
     if (a.sign != b.sign) {
-        return (a.sign) ? b - (-a) : a - (-b);
+        return a.sign ? -1 : 1;
     }
-    size_t max_sz = std::max(a.size(), b.size());
-    uint64_t sum;
-    uint64_t shift = 0;
-    big_integer res;
-    for (size_t i = 0; i <= max_sz; i++) {
-        res.value.push_back(0);
+    int res = big_integer::compare_magnitudes(a, b);
+    return a.sign ? -res : res;
+}
+
+int big_integer::compare_magnitudes(big_integer const& a, big_integer const& b) {
+    if (a.size() != b.size()) {
+        return a.size() < b.size() ? -1 : 1;
     }
-    for (size_t i = 0; i < max_sz; i++) {
-        sum = shift;
-        if (i < a.size()) {
-            sum += a[i];
-        }
-        if (i < b.size()) {
-            sum += b[i];
-        }
-        if (sum > UINT32_MAX) {
-            shift = 1;
-        } else {
-            shift = 0;
+    uint32_t const* x = a.value.limbs();
+    uint32_t const* y = b.value.limbs();
+    for (size_t i = a.size(); i > 0; i--) {
+        if (x[i - 1] != y[i - 1]) {
+            return x[i - 1] < y[i - 1] ? -1 : 1;
         }
-        res.value[i] = static_cast<uint32_t>(sum % u32);
     }
-    res.value[max_sz] = shift;
-    res.sign = a.sign;
-    res.delete_zero();
-    return res;
+    return 0;
 }
 
-big_integer operator-(big_integer a, big_integer const& b) {
-    if (a.sign != b.sign) {
-        return (a.sign) ? -(-a + b) : a + (-b);
+// a + b with the sign of b replaced by b_negative
+void big_integer::assign_sum(big_integer const& a, big_integer const& b, bool b_negative) {
+    bool a_negative = a.sign;
+    if (a_negative == b_negative) {
+        add_magnitudes(a, b);
+        sign = a_negative;
+    } else if (compare_magnitudes(a, b) >= 0) {
+        sub_magnitudes(a, b);
+        sign = a_negative && !(size() == 1 && value[0] == 0);
+    } else {
+        sub_magnitudes(b, a);
+        sign = b_negative;
     }
-    if (a.sign) {
-        return (-b) - (-a);
+}
+
+// Sizes are read before res is resized and the limbs after, so res may alias an operand.
+void big_integer::add_magnitudes(big_integer const& a, big_integer const& b) {
+    bool a_longer = a.size() >= b.size();
+    big_integer const& longer = a_longer ? a : b;
+    big_integer const& shorter = a_longer ? b : a;
+    size_t max_sz = longer.size();
+    size_t min_sz = shorter.size();
+    instrumentation::record_op(bigint_op::add, max_sz);
+    value.resize_uninitialized(max_sz + 1);
+    uint32_t* r = value.mutable_limbs();
+    uint32_t const* x = longer.value.limbs();
+    uint32_t const* y = shorter.value.limbs();
+    uint64_t carry = best_limb_kernels().add_n(r, x, y, min_sz);
+    for (size_t i = min_sz; i < max_sz; i++) {
+        uint64_t sum = static_cast<uint64_t>(x[i]) + carry;
+        r[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
     }
-    if (a < b) {
-        return -(b - a);
+    r[max_sz] = static_cast<uint32_t>(carry);
+    delete_zero();
+}
+
+void big_integer::sub_magnitudes(big_integer const& a, big_integer const& b) {
+    size_t an = a.size();
+    size_t bn = b.size();
+    instrumentation::record_op(bigint_op::sub, an);
+    value.resize_uninitialized(an);
+    uint32_t* r = value.mutable_limbs();
+    uint32_t const* x = a.value.limbs();
+    uint32_t const* y = b.value.limbs();
+    uint64_t borrow = best_limb_kernels().sub_n(r, x, y, bn);
+    for (size_t i = bn; i < an; i++) {
+        uint64_t diff = static_cast<uint64_t>(x[i]) - borrow;
+        r[i] = static_cast<uint32_t>(diff);
+        borrow = (diff >> 32) != 0;
     }
-    uint32_t shift = 0;
-    big_integer res;
-    for (size_t i = 0; i < a.size(); i++) {
-        res.value.push_back(0);
+    delete_zero();
+}
+
+// r[0, xn + yn) = x * y for xn >= yn; rows run along the longer operand,
+// so the kernels get the long loops
+void mul_basecase(uint32_t* r, uint32_t const* x, size_t xn, uint32_t const* y, size_t yn) {
+    limb_kernels const& kernels = best_limb_kernels();
+    r[xn] = kernels.mul_1(r, x, xn, y[0]);
+    for (size_t i = 1; i < yn; i++) {
+        r[i + xn] = kernels.addmul_1(r + i, x, xn, y[i]);
     }
-    for (size_t i = 0; i < a.size(); i++) {
-        if (i >= b.size()) {
-            if (a[i] >= shift) {
-                res.value[i] = a[i] - shift;
-                shift = 0;
-            } else {
-                res.value[i] = UINT32_MAX;
-                shift = 1;
-            }
-        } else if (a[i] >= b[i] + shift) {
-            res.value[i] = a[i] - shift - b[i];
-            shift = 0;
-        } else {
-            res.value[i] = UINT32_MAX - (b[i] - a[i]) - shift + 1;
-            shift = 1;
-        }
+}
+
+// x[0, n) += carry, returns the carry out of the top limb
+uint32_t propagate_carry(uint32_t* x, size_t n, uint32_t carry) {
+    for (size_t i = 0; i < n && carry != 0; i++) {
+        x[i] += carry;
+        carry = x[i] == 0 ? 1 : 0;
+    }
+    return carry;
+}
+
+uint32_t propagate_borrow(uint32_t* x, size_t n, uint32_t borrow) {
+    for (size_t i = 0; i < n && borrow != 0; i++) {
+        borrow = x[i] == 0 ? 1 : 0;
+        x[i]--;
+    }
+    return borrow;
+}
+
+// Scratch limbs karatsuba needs for n-limb operands.
+size_t karatsuba_scratch(size_t n, size_t threshold) {
+    size_t res = 0;
+    while (n >= threshold) {
+        size_t m = n - n / 2 + 1;
+        res += 4 * m;
+        n = m;
     }
-    res.delete_zero();
     return res;
 }
 
-big_integer operator*(big_integer a, big_integer const& b) {
-    if (a == 0 || b == 0) {
-        return 0;
+// r[0, 2n) = x * y for n-limb operands. With x = x1 * B^h + x0 and y alike,
+// the middle product x0 * y1 + x1 * y0 is (x0 + x1)(y0 + y1) - x0 * y0 - x1 * y1.
+void karatsuba(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n, uint32_t* scratch, size_t threshold) {
+    if (n < threshold) {
+        mul_basecase(r, x, n, y, n);
+        return;
     }
-    big_integer res;
-    for (size_t i = 0; i < a.size() + b.size(); i++) {
-        res.value.push_back(0);
+    limb_kernels const& kernels = best_limb_kernels();
+    size_t h = n / 2;
+    size_t m = n - h;
+    uint32_t* sx = scratch;
+    uint32_t* sy = sx + m + 1;
+    uint32_t* mid = sy + m + 1;
+    uint32_t* next = mid + 2 * (m + 1);
+
+    std::copy(x + h, x + n, sx);
+    sx[m] = propagate_carry(sx + h, m - h, kernels.add_n(sx, sx, x, h));
+    std::copy(y + h, y + n, sy);
+    sy[m] = propagate_carry(sy + h, m - h, kernels.add_n(sy, sy, y, h));
+
+    karatsuba(r, x, y, h, next, threshold);
+    karatsuba(r + 2 * h, x + h, y + h, m, next, threshold);
+    karatsuba(mid, sx, sy, m + 1, next, threshold);
+
+    size_t mid_n = 2 * (m + 1);
+    propagate_borrow(mid + 2 * h, mid_n - 2 * h, kernels.sub_n(mid, mid, r, 2 * h));
+    propagate_borrow(mid + 2 * m, mid_n - 2 * m, kernels.sub_n(mid, mid, r + 2 * h, 2 * m));
+    // the middle product is below B^(2n - h), its limbs past r are zero
+    size_t len = std::min(mid_n, 2 * n - h);
+    propagate_carry(r + h + len, 2 * n - h - len, kernels.add_n(r + h, r + h, mid, len));
+}
+
+// r[0, xn + yn) = x * y for xn >= yn
+void mul_limbs(uint32_t* r, uint32_t const* x, size_t xn, uint32_t const* y, size_t yn) {
+    size_t threshold = current_tuning().mul_karatsuba;
+    if (yn < threshold) {
+        mul_basecase(r, x, xn, y, yn);
+        return;
     }
-    for (size_t i = 0; i < a.size(); i++) {
-        uint64_t shift = 0;
-        for (size_t j = 0; j < b.size(); j++) {
-            uint64_t curr_mul = static_cast<uint64_t>(a[i]) * b[j] + res[i + j] + shift;
-            res.value[i + j] = static_cast<uint32_t>(curr_mul % u32);
-            shift = curr_mul / u32;
-        }
-        res.value[i + b.size()] = shift;
+    std::vector<uint32_t> scratch(karatsuba_scratch(yn, threshold));
+    if (xn == yn) {
+        karatsuba(r, x, y, yn, scratch.data(), threshold);
+        return;
     }
-    res.sign = a.sign ^ b.sign;
-    res.delete_zero();
+    // unbalanced: yn-limb slices of x, each product added in at its offset
+    std::fill(r, r + xn + yn, 0);
+    std::vector<uint32_t> product(2 * yn);
+    limb_kernels const& kernels = best_limb_kernels();
+    size_t offset = 0;
+    for (; offset + yn <= xn; offset += yn) {
+        karatsuba(product.data(), x + offset, y, yn, scratch.data(), threshold);
+        uint32_t carry = kernels.add_n(r + offset, r + offset, product.data(), 2 * yn);
+        propagate_carry(r + offset + 2 * yn, xn + yn - offset - 2 * yn, carry);
+    }
+    if (offset < xn) {
+        size_t rest = xn - offset;
+        mul_limbs(product.data(), y, yn, x + offset, rest);
+        kernels.add_n(r + offset, r + offset, product.data(), yn + rest);
+    }
+}
+
+big_integer operator*(big_integer a, big_integer const& b) {
+    big_integer res;
+    mul(res, a, b);
     return res;
 }
 
-big_integer operator/(big_integer a, big_integer const& b) {
-    if (b == 1) {
-        return a;
+void mul(big_integer& res, big_integer const& a, big_integer const& b) {
+    if (&res == &a || &res == &b) {
+        big_integer product;
+        mul(product, a, b);
+        res = product;
+        return;
     }
-    if (b == -1) {
-        return -a;
+    if ((a.size() == 1 && a[0] == 0) || (b.size() == 1 && b[0] == 0)) {
+        res.set_magnitude(0);
+        res.sign = false;
+        return;
     }
+    big_integer const& longer = a.size() >= b.size() ? a : b;
+    big_integer const& shorter = a.size() >= b.size() ? b : a;
+    instrumentation::record_op(bigint_op::mul, longer.size());
+    BIGINT_PROBE2(mul__entry, a.size(), b.size());
+    res.value.resize_uninitialized(a.size() + b.size());
+    mul_limbs(res.value.mutable_limbs(), longer.value.limbs(), longer.size(), shorter.value.limbs(), shorter.size());
+    res.sign = a.sign ^ b.sign;
+    res.delete_zero();
+    BIGINT_PROBE1(mul__return, res.size());
+}
+
+void divrem(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b) {
+    bool q_negative = a.sign ^ b.sign;
+    bool r_negative = a.sign;
     big_integer first = a;
     big_integer second = b;
     first.sign = second.sign = false;
-    big_integer res;
     if (first < second) {
-        return 0;
+        first.sign = r_negative;
+        r = first;
+        q = 0;
+        return;
     }
-    if (b.size() == 1) {
+    if (second == 1) {
+        first.sign = q_negative;
+        q = first;
+        r = 0;
+        return;
+    }
+    instrumentation::record_op(bigint_op::div, first.size());
+    BIGINT_PROBE2(div__entry, first.size(), second.size());
+    big_integer res;
+    if (second.size() == 1) {
         uint64_t rest = 0;
-        uint64_t curr;
-        for (size_t i = 1; i <= a.size(); i++) {
-            curr = rest * u32 + a[a.size() - i];
-            res.value.push_back(static_cast<uint32_t>(curr / b[0]));
-            rest = curr % b[0];
+        uint64_t d = second[0];
+        res.value.resize_uninitialized(first.size());
+        uint32_t const* x = first.value.limbs();
+        uint32_t* z = res.value.mutable_limbs();
+        for (size_t i = first.size(); i > 0; i--) {
+            uint64_t curr = (rest << 32) | x[i - 1];
+            z[i - 1] = static_cast<uint32_t>(curr / d);
+            rest = curr % d;
         }
-        res.value.reverse();
+        first.set_magnitude(rest);
     } else {
         // Algo from article: Multiple-Length Division Revisited: A Tour of the Minefield
         big_integer dq;
@@ -277,14 +532,34 @@ big_integer operator/(big_integer a, big_integer const& b) {
             }
             j--;
         }
+        // the low m limbs left over are the remainder
+        first.delete_zero();
     }
     res.delete_zero();
-    res.sign = a.sign ^ b.sign;
-    return res;
+    res.sign = q_negative;
+    first.sign = r_negative && !(first.size() == 1 && first[0] == 0);
+    BIGINT_PROBE1(div__return, res.size());
+    q = res;
+    r = first;
+}
+
+uint64_t divrem(big_integer& a, uint64_t d) {
+    instrumentation::record_op(bigint_op::scalar, a.size());
+    uint64_t rest = a.divrem_1(d);
+    a.sign = a.sign && !(a.size() == 1 && a[0] == 0);
+    return rest;
+}
+
+big_integer operator/(big_integer a, big_integer const& b) {
+    big_integer r;
+    divrem(a, r, a, b);
+    return a;
 }
 
 big_integer operator%(big_integer a, big_integer const& b) {
-    return a - (a / b) * b;
+    big_integer q;
+    divrem(q, a, a, b);
+    return a;
 }
 
 big_integer operator&(big_integer a, big_integer const& b) {
@@ -300,36 +575,65 @@ big_integer operator^(big_integer a, big_integer const& b) {
 }
 
 big_integer operator<<(big_integer a, int b) {
-    uint32_t shift = 1 << (b % 32);
-    for (int i = 0; i < b / 32; i++) {
-        a *= b32;
+    if (a == 0) {
+        return a;
     }
-    a *= shift;
-    return a;
+    size_t limbs = b / 32;
+    unsigned bits = b % 32;
+    instrumentation::record_op(bigint_op::shl, a.size());
+    big_integer res;
+    res.value.resize_uninitialized(a.size() + limbs + 1);
+    uint32_t const* x = a.value.limbs();
+    uint32_t* r = res.value.mutable_limbs();
+    std::fill(r, r + limbs, 0);
+    uint32_t carry = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        r[limbs + i] = (x[i] << bits) | carry;
+        carry = bits != 0 ? x[i] >> (32 - bits) : 0;
+    }
+    r[limbs + a.size()] = carry;
+    res.sign = a.sign;
+    res.delete_zero();
+    return res;
 }
 
+// Rounds towards negative infinity, like a shift of the two's complement form.
 big_integer operator>>(big_integer a, int b) {
-    for (int i = 0; i < b / 32; i++) {
-        a /= b32;
+    size_t limbs = b / 32;
+    unsigned bits = b % 32;
+    if (limbs >= a.size()) {
+        return a.sign ? -1 : 0;
     }
-    uint32_t shift = 1 << (b % 32);
+    instrumentation::record_op(bigint_op::shr, a.size());
+    uint32_t const* x = a.value.limbs();
+    bool lost = false;
     if (a.sign) {
-        a -= shift - 1;
+        for (size_t i = 0; i < limbs; i++) {
+            lost = lost || x[i] != 0;
+        }
+        lost = lost || (x[limbs] & ((1u << bits) - 1)) != 0;
     }
-    a /= shift;
-    return a;
+    size_t n = a.size() - limbs;
+    big_integer res;
+    res.value.resize_uninitialized(n);
+    uint32_t* r = res.value.mutable_limbs();
+    for (size_t i = 0; i < n; i++) {
+        uint32_t high = (bits != 0 && i + 1 < n) ? x[limbs + i + 1] << (32 - bits) : 0;
+        r[i] = (x[limbs + i] >> bits) | high;
+    }
+    res.delete_zero();
+    if (lost) {
+        res.add_1(1);
+    }
+    res.sign = a.sign && !(res.size() == 1 && res[0] == 0);
+    return res;
 }
 
 bool operator==(big_integer const& a, big_integer const& b) {
-    if (a.size() != b.size()) {
+    if (a.size() != b.size() || a.sign != b.sign) {
         return false;
     }
-    for (size_t i = 0; i < a.size(); i++) {
-        if (a[i] != b[i]) {
-            return false;
-        }
-    }
-    return a.sign == b.sign;
+    return std::equal(a.value.limbs(), a.value.limbs() + a.size(), b.value.limbs());
 }
 
 bool operator!=(big_integer const& a, big_integer const& b) {
@@ -337,21 +641,7 @@ bool operator!=(big_integer const& a, big_integer const& b) {
 }
 
 bool operator<(big_integer const& a, big_integer const& b) {
-    if (a.sign != b.sign) {
-        return a.sign;
-    }
-    if (a.sign) {
-        return -a > -b;
-    }
-    if (a.size() != b.size()) {
-        return a.size() < b.size();
-    }
-    for (size_t i = 1; i <= a.size(); i++) {
-        if (a[a.size() - i] != b[a.size() - i]) {
-            return a[a.size() - i] < b[a.size() - i];
-        }
-    }
-    return false;
+    return compare(a, b) < 0;
 }
 
 bool operator>(big_integer const& a, big_integer const& b) {
@@ -367,41 +657,394 @@ bool operator>=(big_integer const& a, big_integer const& b) {
 }
 
 std::string to_string(big_integer const& a) {
-    if (a == 0) {
+    std::vector<uint32_t> chunks;
+    a.decimal_chunks(chunks);
+    std::string str = a.sign ? "-" : "";
+    str += std::to_string(chunks.back());
+    char block[DECIMAL_CHUNK_DIGITS];
+    for (size_t i = chunks.size() - 1; i > 0; i--) {
+        write_decimal_chunk(block, chunks[i - 1]);
+        str.append(block, DECIMAL_CHUNK_DIGITS);
+    }
+    return str;
+}
+
+std::string to_string(big_integer const& a, int base) {
+    if (base == 10) {
+        return to_string(a);
+    }
+    int bits = radix_bits(base);
+    instrumentation::record_op(bigint_op::to_string, a.size());
+    size_t digits = (a.bit_length() + bits - 1) / bits;
+    if (digits == 0) {
         return "0";
     }
-    std::string str;
-    big_integer curr = a;
-    while (curr != 0) {
-        big_integer mod10 = curr % 10;
-        str += char (mod10[0] + 48);
-        curr /= 10;
+    std::string str(digits + (a.sign ? 1 : 0), '-');
+    uint32_t mask = (1u << bits) - 1;
+    for (size_t i = 0; i < digits; i++) {
+        size_t offset = i * bits;
+        size_t limb = offset / 32;
+        size_t shift = offset % 32;
+        uint32_t digit = a[limb] >> shift;
+        if (shift + bits > 32 && limb + 1 < a.size()) {
+            digit |= a[limb + 1] << (32 - shift);
+        }
+        str[str.size() - 1 - i] = radix_digits[digit & mask];
     }
-    str += a.sign ? "-" : "";
-    std::reverse(str.begin(), str.end());
     return str;
 }
 
 std::ostream& operator<<(std::ostream& s, big_integer const& a) {
-    return s << to_string(a);
+    std::ostream::sentry guard(s);
+    if (!guard) {
+        return s;
+    }
+    std::vector<uint32_t> chunks;
+    a.decimal_chunks(chunks);
+    std::string head = a.sign ? "-" : "";
+    head += std::to_string(chunks.back());
+
+    std::streamsize length = head.size() + DECIMAL_CHUNK_DIGITS * (chunks.size() - 1);
+    std::streamsize padding = s.width() > length ? s.width() - length : 0;
+    std::ios::fmtflags adjust = s.flags() & std::ios::adjustfield;
+    s.width(0);
+    std::streambuf* buf = s.rdbuf();
+    bool ok = true;
+    if (adjust == std::ios::internal && a.sign) {
+        ok = buf->sputc('-') != std::char_traits<char>::eof();
+        head.erase(0, 1);
+    }
+    if (adjust != std::ios::left) {
+        for (std::streamsize i = 0; i < padding && ok; i++) {
+            ok = buf->sputc(s.fill()) != std::char_traits<char>::eof();
+        }
+    }
+    ok = ok && buf->sputn(head.data(), head.size()) == static_cast<std::streamsize>(head.size());
+
+    char block[DECIMAL_CHUNK_DIGITS * DECIMAL_BLOCK_CHUNKS];
+    size_t used = 0;
+    for (size_t i = chunks.size() - 1; i > 0 && ok; i--) {
+        write_decimal_chunk(block + used, chunks[i - 1]);
+        used += DECIMAL_CHUNK_DIGITS;
+        if (used == sizeof(block) || i == 1) {
+            ok = buf->sputn(block, used) == static_cast<std::streamsize>(used);
+            used = 0;
+        }
+    }
+    if (adjust == std::ios::left) {
+        for (std::streamsize i = 0; i < padding && ok; i++) {
+            ok = buf->sputc(s.fill()) != std::char_traits<char>::eof();
+        }
+    }
+    if (!ok) {
+        s.setstate(std::ios::badbit);
+    }
+    return s;
 }
 
-void big_integer::delete_zero() {
-    while (size() > 1 && value.back() == 0) {
-        value.pop_back();
+std::istream& operator>>(std::istream& s, big_integer& a) {
+    std::istream::sentry guard(s);
+    if (!guard) {
+        return s;
+    }
+    typedef std::char_traits<char> traits;
+    std::streambuf* buf = s.rdbuf();
+    traits::int_type c = buf->sgetc();
+    bool negative = false;
+    if (c == '-' || c == '+') {
+        negative = (c == '-');
+        c = buf->snextc();
     }
+    big_integer res;
+    uint32_t chunk = 0;
+    uint32_t chunk_pow = 1;
+    bool has_digits = false;
+    while (c != traits::eof() && c >= '0' && c <= '9') {
+        chunk = chunk * 10 + static_cast<uint32_t>(c - '0');
+        chunk_pow *= 10;
+        has_digits = true;
+        if (chunk_pow == DECIMAL_CHUNK) {
+            res.mul_add(chunk_pow, chunk);
+            chunk = 0;
+            chunk_pow = 1;
+        }
+        c = buf->snextc();
+    }
+    if (chunk_pow != 1) {
+        res.mul_add(chunk_pow, chunk);
+    }
+    std::ios::iostate state = std::ios::goodbit;
+    if (c == traits::eof()) {
+        state |= std::ios::eofbit;
+    }
+    if (has_digits) {
+        res.sign = negative && !(res.size() == 1 && res[0] == 0);
+        a = res;
+    } else {
+        state |= std::ios::failbit;
+    }
+    s.setstate(state);
+    return s;
 }
 
-void big_integer::inverse(size_t sz) {
-    for (size_t i = size(); i < sz; i++) {
-        value.push_back(0);
+void big_integer::mul_add(uint32_t mul, uint32_t add) {
+    uint32_t* x = value.mutable_limbs();
+    uint64_t carry = add;
+    for (size_t i = 0; i < size(); i++) {
+        uint64_t curr = static_cast<uint64_t>(x[i]) * mul + carry;
+        x[i] = static_cast<uint32_t>(curr);
+        carry = curr >> 32;
     }
-    if (sign) {
-        sign = false;
+    if (carry != 0) {
+        value.push_back(static_cast<uint32_t>(carry));
+    }
+    delete_zero();
+}
+
+void big_integer::set_magnitude(uint64_t a) {
+    value = buffer(static_cast<uint32_t>(a));
+    if ((a >> 32) != 0) {
+        value.push_back(static_cast<uint32_t>(a >> 32));
+    }
+}
+
+bool big_integer::magnitude_less(uint64_t a) const {
+    if (size() > 2) {
+        return false;
+    }
+    uint64_t curr = value[0];
+    if (size() == 2) {
+        curr |= static_cast<uint64_t>(value[1]) << 32;
+    }
+    return curr < a;
+}
+
+void big_integer::add_1(uint64_t a) {
+    uint32_t* x = value.mutable_limbs();
+    uint64_t carry = a;
+    for (size_t i = 0; i < size() && carry != 0; i++) {
+        uint64_t sum = static_cast<uint64_t>(x[i]) + static_cast<uint32_t>(carry);
+        x[i] = static_cast<uint32_t>(sum);
+        carry = (carry >> 32) + (sum >> 32);
+    }
+    while (carry != 0) {
+        value.push_back(static_cast<uint32_t>(carry));
+        carry >>= 32;
+    }
+}
+
+// |this| must not be less than a
+void big_integer::sub_1(uint64_t a) {
+    uint32_t* x = value.mutable_limbs();
+    uint64_t borrow = a;
+    for (size_t i = 0; i < size() && borrow != 0; i++) {
+        uint32_t low = static_cast<uint32_t>(borrow);
+        uint32_t curr = x[i];
+        x[i] = curr - low;
+        borrow = (borrow >> 32) + (curr < low ? 1 : 0);
+    }
+    delete_zero();
+}
+
+void big_integer::mul_1(uint64_t a) {
+    uint32_t* x = value.mutable_limbs();
+    if (a <= UINT32_MAX) {
+        uint32_t carry = best_limb_kernels().mul_1(x, x, size(), static_cast<uint32_t>(a));
+        if (carry != 0) {
+            value.push_back(static_cast<uint32_t>(carry));
+        }
+    } else {
+        uint128_t carry = 0;
         for (size_t i = 0; i < size(); i++) {
-           value[i] = ~value[i];
+            uint128_t curr = static_cast<uint128_t>(x[i]) * a + carry;
+            x[i] = static_cast<uint32_t>(curr);
+            carry = curr >> 32;
+        }
+        while (carry != 0) {
+            value.push_back(static_cast<uint32_t>(carry));
+            carry >>= 32;
         }
-        *this += 1;
+    }
+    delete_zero();
+}
+
+// |this| /= a, returns |this| % a
+uint64_t big_integer::divrem_1(uint64_t a) {
+    uint32_t* x = value.mutable_limbs();
+    uint64_t res;
+    if (a <= UINT32_MAX) {
+        uint64_t rest = 0;
+        for (size_t i = size(); i > 0; i--) {
+            uint64_t curr = (rest << 32) | x[i - 1];
+            x[i - 1] = static_cast<uint32_t>(curr / a);
+            rest = curr % a;
+        }
+        res = rest;
+    } else {
+        uint128_t rest = 0;
+        for (size_t i = size(); i > 0; i--) {
+            uint128_t curr = (rest << 32) | x[i - 1];
+            x[i - 1] = static_cast<uint32_t>(curr / a);
+            rest = curr % a;
+        }
+        res = static_cast<uint64_t>(rest);
+    }
+    delete_zero();
+    return res;
+}
+
+void big_integer::add_scalar(bool negative, uint64_t magnitude) {
+    instrumentation::record_op(bigint_op::scalar, size());
+    if (magnitude == 0) {
+        return;
+    }
+    if (size() == 1 && value[0] == 0) {
+        set_magnitude(magnitude);
+        sign = negative;
+    } else if (sign == negative) {
+        add_1(magnitude);
+    } else if (magnitude_less(magnitude)) {
+        uint64_t curr = value[0];
+        if (size() == 2) {
+            curr |= static_cast<uint64_t>(value[1]) << 32;
+        }
+        set_magnitude(magnitude - curr);
+        sign = negative;
+    } else {
+        sub_1(magnitude);
+        sign = sign && !(size() == 1 && value[0] == 0);
+    }
+}
+
+void big_integer::mul_scalar(bool negative, uint64_t magnitude) {
+    instrumentation::record_op(bigint_op::scalar, size());
+    if (magnitude == 0 || (size() == 1 && value[0] == 0)) {
+        set_magnitude(0);
+        sign = false;
+        return;
+    }
+    mul_1(magnitude);
+    sign = sign != negative;
+}
+
+void big_integer::div_scalar(bool negative, uint64_t magnitude) {
+    instrumentation::record_op(bigint_op::scalar, size());
+    divrem_1(magnitude);
+    sign = (sign != negative) && !(size() == 1 && value[0] == 0);
+}
+
+void big_integer::mod_scalar(uint64_t magnitude) {
+    instrumentation::record_op(bigint_op::scalar, size());
+    uint64_t rest = divrem_1(magnitude);
+    set_magnitude(rest);
+    sign = sign && rest != 0;
+}
+
+// Base 10^9 digits of |a|, least significant first; always at least one.
+// Large values are split recursively, a = q * 10^(9 * 2^j) + r, with each
+// division done as a multiplication by the power's reciprocal. That costs a
+// few multiplications per level instead of a quadratic number of divisions.
+void big_integer::decimal_chunks(std::vector<uint32_t>& chunks) const {
+    instrumentation::record_op(bigint_op::to_string, size());
+    BIGINT_PROBE1(to_string__entry, size());
+    chunks.clear();
+    size_t estimate = size() * 32 / 29 + 1;
+    chunks.reserve(estimate);
+    big_integer a = *this;
+    a.sign = false;
+    if (estimate <= DECIMAL_SPLIT_CHUNKS) {
+        schoolbook_chunks(a, chunks);
+    } else {
+        // powers[j] = 10^(9 * 2^j); a < powers[j]^2 has at most 2^(j + 1) chunks
+        std::vector<big_integer> powers(1, big_integer(DECIMAL_CHUNK));
+        std::vector<big_integer> reciprocals(1);
+        while ((static_cast<size_t>(2) << (powers.size() - 1)) < estimate) {
+            powers.push_back(powers.back() * powers.back());
+            // only levels above the schoolbook size are ever split
+            bool split = (static_cast<size_t>(2) << (powers.size() - 1)) > DECIMAL_SPLIT_CHUNKS;
+            reciprocals.push_back(split ? reciprocal(powers.back(), 2 * powers.back().bit_length()) : big_integer());
+        }
+        split_chunks(a, powers.size() - 1, powers, reciprocals, chunks);
+        while (chunks.size() > 1 && chunks.back() == 0) {
+            chunks.pop_back();
+        }
+    }
+    BIGINT_PROBE1(to_string__return, chunks.size());
+}
+
+void big_integer::schoolbook_chunks(big_integer const& a, std::vector<uint32_t>& chunks) {
+    std::vector<uint32_t> curr(a.value.limbs(), a.value.limbs() + a.size());
+    do {
+        uint64_t rest = 0;
+        for (size_t i = curr.size(); i > 0; i--) {
+            uint64_t cur = (rest << 32) | curr[i - 1];
+            curr[i - 1] = static_cast<uint32_t>(cur / DECIMAL_CHUNK);
+            rest = cur % DECIMAL_CHUNK;
+        }
+        chunks.push_back(static_cast<uint32_t>(rest));
+        while (!curr.empty() && curr.back() == 0) {
+            curr.pop_back();
+        }
+    } while (!curr.empty());
+}
+
+// Appends exactly 2^(level + 1) chunks of 0 <= a < powers[level]^2.
+void big_integer::split_chunks(big_integer const& a, size_t level, std::vector<big_integer> const& powers,
+                               std::vector<big_integer> const& reciprocals, std::vector<uint32_t>& chunks) {
+    size_t count = static_cast<size_t>(2) << level;
+    size_t end = chunks.size() + count;
+    if (a.size() == 1 && a[0] == 0) {
+        chunks.resize(end, 0);
+        return;
+    }
+    if (count <= DECIMAL_SPLIT_CHUNKS) {
+        schoolbook_chunks(a, chunks);
+        chunks.resize(end, 0);
+        return;
+    }
+    // Only the top bits + 64 bits of a < 2^(2 * bits) take part, the
+    // estimate is still at most two below the quotient.
+    big_integer const& p = powers[level];
+    int bits = static_cast<int>(p.bit_length());
+    big_integer q = ((a >> (bits - 64)) * reciprocals[level]) >> (bits + 64);
+    big_integer r = a - q * p;
+    while (r >= p) {
+        r -= p;
+        q += 1;
+    }
+    split_chunks(r, level - 1, powers, reciprocals, chunks);
+    split_chunks(q, level - 1, powers, reciprocals, chunks);
+}
+
+big_integer big_integer::reciprocal(big_integer const& d, size_t k) {
+    size_t l = d.bit_length();
+    size_t n = k - l + 1;
+    if (n <= RECIPROCAL_SCHOOLBOOK_BITS) {
+        return (big_integer(1) << static_cast<int>(k)) / d;
+    }
+    // Half as many bits from the top of d, plus guard bits, scaled back up;
+    // one Newton step x += x * (2^k - d * x) / 2^k then doubles the precision.
+    size_t h = n / 2 + 32;
+    size_t t = l > h + 32 ? l - (h + 32) : 0;
+    size_t s = n - h;
+    big_integer x = reciprocal(d >> static_cast<int>(t), k - t - s) << static_cast<int>(s);
+    big_integer one = big_integer(1) << static_cast<int>(k);
+    x += (x * (one - d * x)) >> static_cast<int>(k);
+    big_integer r = one - d * x;
+    while (r < 0) {
+        x -= 1;
+        r += d;
+    }
+    while (r >= d) {
+        x += 1;
+        r -= d;
+    }
+    return x;
+}
+
+void big_integer::delete_zero() {
+    while (size() > 1 && value.back() == 0) {
+        value.pop_back();
     }
 }
 
@@ -430,13 +1073,13 @@ bool smaller(big_integer const &a, big_integer const &b, size_t id) {
 }
 
 void difference(big_integer &a, big_integer const &b, size_t id) {
-    size_t start = a.size() - id;
-    int64_t borrow = 0;
-    for (size_t i = 0; i < id; i++) {
-        uint32_t val = i < b.size() ? b[i] : 0;
-        uint64_t diff = (uint64_t) a[start + i] - val + u32 - borrow;
-        a.value[start + i] = diff % u32;
-        borrow = 1 - diff / u32;
+    uint32_t* x = a.value.mutable_limbs() + (a.size() - id);
+    size_t common = std::min(id, b.size());
+    uint64_t borrow = best_limb_kernels().sub_n(x, x, b.value.limbs(), common);
+    for (size_t i = common; i < id; i++) {
+        uint64_t diff = static_cast<uint64_t>(x[i]) - borrow;
+        x[i] = static_cast<uint32_t>(diff);
+        borrow = (diff >> 32) != 0;
     }
 }
 
@@ -451,24 +1094,75 @@ uint32_t bin_op(uint32_t a, uint32_t b, int mode) {
     }
 }
 
+size_t first_nonzero(uint32_t const* x, size_t n) {
+    size_t i = 0;
+    while (i < n && x[i] == 0) {
+        i++;
+    }
+    return i;
+}
 
+// Limb i of the two's complement of a magnitude whose lowest nonzero limb is `low`:
+// negated at `low`, inverted above it, zero below it.
+uint32_t twos_limb(uint32_t const* x, size_t n, bool negative, size_t low, size_t i) {
+    uint32_t limb = i < n ? x[i] : 0;
+    if (!negative) {
+        return limb;
+    }
+    return i <= low ? 0u - limb : ~limb;
+}
+
+// Operates on the two's complement forms. Above the lowest nonzero limb of every
+// negative operand its limbs are plain inversions, which the kernels apply as
+// an xor mask while streaming; only the limbs up to there are done one by one.
 big_integer bin_operator(big_integer a, big_integer const& b, int mode) {
-    big_integer first_num = a;
-    big_integer second_num = b;
+    bitwise_kernels const& kernels = best_bitwise_kernels();
+    size_t n = std::max(a.size(), b.size());
+    instrumentation::record_op(bigint_op::bitwise, n);
+    uint32_t const* x = a.value.limbs();
+    uint32_t const* y = b.value.limbs();
+    size_t low_x = a.sign ? first_nonzero(x, a.size()) : 0;
+    size_t low_y = b.sign ? first_nonzero(y, b.size()) : 0;
+    size_t head = std::min(n, std::max(a.sign ? low_x + 1 : 0, b.sign ? low_y + 1 : 0));
+
     big_integer res;
-    size_t max_sz = std::max(a.size(), b.size());
-    first_num.inverse(max_sz);
-    second_num.inverse(max_sz);
-    res.value.resize(max_sz);
-    for (size_t i = 0; i < max_sz; i++) {
-        res.value[i] = bin_op(first_num[i], second_num[i], mode);
-    }
-    bool is_inv = bin_op(a.sign, b.sign, mode);
-    if (is_inv) {
-        res.sign = true;
-        res.inverse(max_sz);
-        res.sign = true;
+    res.value.resize_uninitialized(n);
+    uint32_t* r = res.value.mutable_limbs();
+    for (size_t i = 0; i < head; i++) {
+        r[i] = bin_op(twos_limb(x, a.size(), a.sign, low_x, i), twos_limb(y, b.size(), b.sign, low_y, i), mode);
+    }
+    uint32_t mask_x = a.sign ? UINT32_MAX : 0;
+    uint32_t mask_y = b.sign ? UINT32_MAX : 0;
+    size_t common = std::min(a.size(), b.size());
+    if (head < common) {
+        kernels.op_n(r + head, x + head, mask_x, y + head, mask_y, common - head, mode);
+    }
+    size_t tail = std::max(head, common);
+    if (tail < n) {
+        // the shorter operand is sign extended
+        bool a_longer = a.size() > b.size();
+        uint32_t const* longer = a_longer ? x : y;
+        uint32_t mask = a_longer ? mask_x : mask_y;
+        uint32_t ext = a_longer ? mask_y : mask_x;
+        if ((mode == 1 && ext == 0) || (mode == 2 && ext != 0)) {
+            std::fill(r + tail, r + n, ext);
+        } else {
+            kernels.xor_n(r + tail, longer + tail, mode == 3 ? mask ^ ext : mask, n - tail);
+        }
     }
+
+    res.sign = bin_op(a.sign, b.sign, mode);
+    if (res.sign) {
+        // back from two's complement; all n limbs zero stands for -2^(32n)
+        size_t low = first_nonzero(r, n);
+        if (low == n) {
+            res.value.push_back(1);
+        } else {
+            r[low] = 0u - r[low];
+            kernels.xor_n(r + low + 1, r + low + 1, UINT32_MAX, n - low - 1);
+        }
+    }
+    res.delete_zero();
     return res;
 }
 
@@ -476,6 +1170,14 @@ size_t big_integer::size() const {
     return value.get_size();
 }
 
+size_t big_integer::bit_length() const {
+    size_t bits = 32 * size();
+    while (bits > 0 && ((value[(bits - 1) / 32] >> ((bits - 1) % 32)) & 1) == 0) {
+        bits--;
+    }
+    return bits;
+}
+
 uint32_t big_integer::operator[](const size_t id) const {
     return value[id];
 }
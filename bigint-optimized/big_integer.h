@@ -5,29 +5,95 @@
 #include <string>
 #include <limits>
 #include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
 #include "buffer.h"
+#include "limb_allocator.h"
 
 struct big_integer
 {
 private:
     void delete_zero();
-    void inverse(size_t sz);
     friend uint32_t trial(big_integer &a, big_integer const &b);
     friend bool smaller(big_integer const &a, big_integer const &b, size_t index);
     friend void difference(big_integer &a, big_integer const &b, size_t index);
     friend big_integer bin_operator(big_integer a, big_integer const& b, int mode);
+    friend uint32_t mod_small(big_integer const& a, uint32_t m);
+    friend struct montgomery_context;
+    friend struct mapped_big_integer_array;
+    friend struct big_integer_accumulator;
+    friend void write_big_integer_array(std::string const& path, std::vector<big_integer> const& values);
+    big_integer(buffer const& limbs, bool sign);
     size_t size() const;
+    size_t bit_length() const;
     uint32_t operator[](const size_t id) const;
+    void mul_add(uint32_t mul, uint32_t add);
+    void set_magnitude(uint64_t a);
+    bool magnitude_less(uint64_t a) const;
+
+    // Single-limb kernels on the magnitude, each a single pass over the limbs.
+    void add_1(uint64_t a);
+    void sub_1(uint64_t a);
+    void mul_1(uint64_t a);
+    uint64_t divrem_1(uint64_t a);
+
+    void add_scalar(bool negative, uint64_t magnitude);
+    void mul_scalar(bool negative, uint64_t magnitude);
+    void div_scalar(bool negative, uint64_t magnitude);
+    void mod_scalar(uint64_t magnitude);
+
+    template <typename T>
+    static bool scalar_negative(T a) {
+        return a < 0;
+    }
+    template <typename T>
+    static uint64_t scalar_magnitude(T a) {
+        return a < 0 ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a);
+    }
+    void decimal_chunks(std::vector<uint32_t>& chunks) const;
+    static void schoolbook_chunks(big_integer const& a, std::vector<uint32_t>& chunks);
+    static void split_chunks(big_integer const& a, size_t level, std::vector<big_integer> const& powers,
+                             std::vector<big_integer> const& reciprocals, std::vector<uint32_t>& chunks);
+    // floor(2^k / d) for d > 0 and k >= bit_length(d)
+    static big_integer reciprocal(big_integer const& d, size_t k);
+
+    // Magnitude kernels writing into *this, which may be one of the operands.
+    static int compare_magnitudes(big_integer const& a, big_integer const& b);
+    void add_magnitudes(big_integer const& a, big_integer const& b);
+    // |a| >= |b|
+    void sub_magnitudes(big_integer const& a, big_integer const& b);
+    void assign_sum(big_integer const& a, big_integer const& b, bool b_negative);
+
+    template <typename URBG>
+    struct limb_source;
+    template <typename URBG>
+    void fill_random(size_t bits, limb_source<URBG>& src);
 public:
     big_integer();
     big_integer(big_integer const& other);
     big_integer(int a);
     big_integer(uint32_t a);
     explicit big_integer(std::string const& str);
+    // Bases 2, 8, 16, 32 and 64 map digits straight onto limb bits, 10 is the decimal path.
+    big_integer(std::string const& str, int base);
     ~big_integer();
 
+    // Uniform in [0, 2^bits).
+    template <typename URBG>
+    static big_integer random(size_t bits, URBG&& rng);
+    // Uniform in [0, n), n must be positive.
+    template <typename URBG>
+    static big_integer random_below(big_integer const& n, URBG&& rng);
+    // `count` values uniform in [0, 2^bits) drawn from one limb stream.
+    template <typename URBG>
+    static std::vector<big_integer> random_n(size_t count, size_t bits, URBG&& rng);
+
     big_integer& operator=(big_integer const& other);
 
+    // Copy that shares no limbs with *this; they come from the current limb_allocator.
+    big_integer deep_copy() const;
+
     big_integer& operator+=(big_integer const& rhs);
     big_integer& operator-=(big_integer const& rhs);
     big_integer& operator*=(big_integer const& rhs);
@@ -38,6 +104,38 @@ public:
     big_integer& operator|=(big_integer const& rhs);
     big_integer& operator^=(big_integer const& rhs);
 
+    // Integral operands go straight to the single-limb kernels
+    // instead of being converted to a big_integer first.
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, big_integer&>::type operator+=(T rhs) {
+        add_scalar(scalar_negative(rhs), scalar_magnitude(rhs));
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, big_integer&>::type operator-=(T rhs) {
+        add_scalar(!scalar_negative(rhs), scalar_magnitude(rhs));
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, big_integer&>::type operator*=(T rhs) {
+        mul_scalar(scalar_negative(rhs), scalar_magnitude(rhs));
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, big_integer&>::type operator/=(T rhs) {
+        div_scalar(scalar_negative(rhs), scalar_magnitude(rhs));
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, big_integer&>::type operator%=(T rhs) {
+        mod_scalar(scalar_magnitude(rhs));
+        return *this;
+    }
+
     big_integer& operator<<=(int rhs);
     big_integer& operator>>=(int rhs);
 
@@ -64,6 +162,22 @@ public:
     friend big_integer operator<<(big_integer a, int b);
     friend big_integer operator>>(big_integer a, int b);
 
+    // res = a + b, a - b, a * b, reusing the limbs res owns when it is not shared.
+    // res may be a or b. Operands are only read, never copied, so different
+    // threads may use the same operands as long as each writes its own res.
+    friend void add(big_integer& res, big_integer const& a, big_integer const& b);
+    friend void sub(big_integer& res, big_integer const& a, big_integer const& b);
+    friend void mul(big_integer& res, big_integer const& a, big_integer const& b);
+
+    // q = a / b and r = a % b from one division, truncated like the operators,
+    // so r has the sign of a. q and r must be different objects, either may be a or b.
+    friend void divrem(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+    // a /= d in place in one pass over the limbs, returns |a| % d; d must not be 0.
+    friend uint64_t divrem(big_integer& a, uint64_t d);
+
+    // -1, 0 or 1 as a is less than, equal to or greater than b
+    friend int compare(big_integer const& a, big_integer const& b);
+
     friend bool operator==(big_integer const& a, big_integer const& b);
     friend bool operator!=(big_integer const& a, big_integer const& b);
     friend bool operator<(big_integer const& a, big_integer const& b);
@@ -72,10 +186,142 @@ public:
     friend bool operator>=(big_integer const& a, big_integer const& b);
 
     friend std::string to_string(big_integer const& a);
+    friend std::string to_string(big_integer const& a, int base);
     friend std::ostream& operator<<(std::ostream& s, big_integer const& a);
+    friend std::istream& operator>>(std::istream& s, big_integer& a);
+
+    friend size_t serialized_size(big_integer const& a);
+    friend size_t serialize(big_integer const& a, uint8_t* out);
+    friend big_integer deserialize(uint8_t const* data, size_t size, size_t* consumed);
 private:
     buffer value;
     bool sign;
 };
 
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer>::type operator+(big_integer a, T b) {
+    return a += b;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer>::type operator+(T a, big_integer b) {
+    return b += a;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer>::type operator-(big_integer a, T b) {
+    return a -= b;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer>::type operator-(T a, big_integer b) {
+    return -(b -= a);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer>::type operator*(big_integer a, T b) {
+    return a *= b;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer>::type operator*(T a, big_integer b) {
+    return b *= a;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer>::type operator/(big_integer a, T b) {
+    return a /= b;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer>::type operator%(big_integer a, T b) {
+    return a %= b;
+}
+
+// Draws whole limbs from the generator: one limb per call for 32-bit engines,
+// two for 64-bit ones and a uniform distribution for everything else.
+template <typename URBG>
+struct big_integer::limb_source {
+    typedef typename URBG::result_type result_type;
+
+    explicit limb_source(URBG& rng) : rng(rng), spare(0), has_spare(false) {}
+
+    uint32_t next() {
+        uint64_t range = static_cast<uint64_t>(URBG::max() - URBG::min());
+        if (range == UINT64_MAX) {
+            if (has_spare) {
+                has_spare = false;
+                return spare;
+            }
+            uint64_t val = static_cast<uint64_t>(rng() - URBG::min());
+            spare = static_cast<uint32_t>(val >> 32);
+            has_spare = true;
+            return static_cast<uint32_t>(val);
+        }
+        if (range == UINT32_MAX) {
+            return static_cast<uint32_t>(rng() - URBG::min());
+        }
+        return dist(rng);
+    }
+
+private:
+    URBG& rng;
+    uint32_t spare;
+    bool has_spare;
+    std::uniform_int_distribution<uint32_t> dist;
+};
+
+template <typename URBG>
+void big_integer::fill_random(size_t bits, limb_source<URBG>& src) {
+    sign = false;
+    if (bits == 0) {
+        value = buffer(0);
+        return;
+    }
+    size_t limbs = (bits + 31) / 32;
+    uint32_t top_mask = (bits % 32 == 0) ? UINT32_MAX : (static_cast<uint32_t>(1) << (bits % 32)) - 1;
+    value.resize_uninitialized(limbs);
+    uint32_t* r = value.mutable_limbs();
+    for (size_t i = 0; i < limbs; i++) {
+        r[i] = src.next();
+    }
+    r[limbs - 1] &= top_mask;
+    delete_zero();
+}
+
+template <typename URBG>
+big_integer big_integer::random(size_t bits, URBG&& rng) {
+    typedef typename std::remove_reference<URBG>::type engine;
+    limb_source<engine> src(rng);
+    big_integer res;
+    res.fill_random(bits, src);
+    return res;
+}
+
+template <typename URBG>
+big_integer big_integer::random_below(big_integer const& n, URBG&& rng) {
+    if (n <= 0) {
+        throw std::invalid_argument("random_below bound must be positive");
+    }
+    typedef typename std::remove_reference<URBG>::type engine;
+    limb_source<engine> src(rng);
+    size_t bits = n.bit_length();
+    big_integer res;
+    do {
+        res.fill_random(bits, src);
+    } while (res >= n);
+    return res;
+}
+
+template <typename URBG>
+std::vector<big_integer> big_integer::random_n(size_t count, size_t bits, URBG&& rng) {
+    typedef typename std::remove_reference<URBG>::type engine;
+    limb_source<engine> src(rng);
+    std::vector<big_integer> res(count);
+    for (size_t i = 0; i < count; i++) {
+        res[i].fill_random(bits, src);
+    }
+    return res;
+}
+
 #endif // BIG_INTEGER_H
\ No newline at end of file
@@ -0,0 +1,106 @@
+// Measures the algorithm crossovers of big_integer on this machine and writes
+// them as a tuning file for BIGINT_TUNING_FILE (see tuning.h).
+//
+// usage: bigint_tune [--output FILE] [--budget-ms MS]
+// Without --output the file goes to stdout. Every timing repeats the operation
+// for at least MS milliseconds.
+//
+// mul_karatsuba is the smallest size at which one level of Karatsuba over
+// basecase products beats the basecase product of the same size, confirmed
+// on the next sizes as well so that one noisy sample does not decide it.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#include "big_integer.h"
+#include "tuning.h"
+
+namespace {
+const size_t MIN_SIZE = 8;
+const size_t MAX_SIZE = 1024;
+const size_t CONFIRMATIONS = 3;
+
+volatile size_t sink;
+
+double time_mul(big_integer const& a, big_integer const& b, double budget_ns) {
+    for (size_t iterations = 1;; iterations *= 2) {
+        size_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            checksum += static_cast<size_t>(a * b != 0);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        sink = checksum;
+        if (ns >= budget_ns) {
+            return ns / iterations;
+        }
+    }
+}
+
+// Time of an n-limb product with Karatsuba from `threshold` limbs on.
+double time_mul(size_t n, size_t threshold, double budget_ns, std::mt19937_64& rng) {
+    big_integer a = big_integer::random(32 * n, rng) | (big_integer(1) << (32 * n - 1));
+    big_integer b = big_integer::random(32 * n, rng) | (big_integer(1) << (32 * n - 1));
+    big_integer_tuning tuning = current_tuning();
+    tuning.mul_karatsuba = threshold;
+    set_tuning(tuning);
+    return time_mul(a, b, budget_ns);
+}
+
+size_t tune_mul_karatsuba(double budget_ns, std::mt19937_64& rng) {
+    size_t wins = 0;
+    size_t first_win = 0;
+    for (size_t n = MIN_SIZE; n <= MAX_SIZE; n += n / 8) {
+        double basecase = time_mul(n, MAX_SIZE * 2, budget_ns, rng);
+        double karatsuba = time_mul(n, n, budget_ns, rng);
+        std::cerr << "mul " << n << " limbs: basecase " << basecase << " ns, karatsuba " << karatsuba << " ns\n";
+        if (karatsuba < basecase) {
+            if (wins++ == 0) {
+                first_win = n;
+            }
+            if (wins == CONFIRMATIONS) {
+                return first_win;
+            }
+        } else {
+            wins = 0;
+        }
+    }
+    return wins != 0 ? first_win : MAX_SIZE;
+}
+}
+
+int main(int argc, char** argv) {
+    char const* output = nullptr;
+    double budget_ns = 2e7;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc) {
+            budget_ns = std::strtod(argv[++i], nullptr) * 1e6;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--output FILE] [--budget-ms MS]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(2020);
+    big_integer_tuning res = default_tuning();
+    res.mul_karatsuba = tune_mul_karatsuba(budget_ns, rng);
+    set_tuning(res);
+
+    if (output == nullptr) {
+        write_tuning(std::cout, res);
+        return 0;
+    }
+    std::ofstream out(output);
+    write_tuning(out, res);
+    if (!out) {
+        std::cerr << "cannot write " << output << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "bitwise_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BIGINT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+template <int MODE>
+uint32_t apply(uint32_t a, uint32_t b) {
+    return MODE == 1 ? (a & b) : MODE == 2 ? (a | b) : (a ^ b);
+}
+
+template <int MODE>
+void op_n_scalar(uint32_t* r, uint32_t const* x, uint32_t mx, uint32_t const* y, uint32_t my, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        r[i] = apply<MODE>(x[i] ^ mx, y[i] ^ my);
+    }
+}
+
+void op_n_scalar(uint32_t* r, uint32_t const* x, uint32_t mx, uint32_t const* y, uint32_t my, size_t n, int mode) {
+    switch (mode) {
+        case 1:
+            return op_n_scalar<1>(r, x, mx, y, my, n);
+        case 2:
+            return op_n_scalar<2>(r, x, mx, y, my, n);
+        default:
+            return op_n_scalar<3>(r, x, mx, y, my, n);
+    }
+}
+
+void xor_n_scalar(uint32_t* r, uint32_t const* x, uint32_t mask, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        r[i] = x[i] ^ mask;
+    }
+}
+
+const bitwise_kernels scalar_kernels = {"scalar", op_n_scalar, xor_n_scalar};
+
+#ifdef BIGINT_X86_KERNELS
+template <int MODE>
+__attribute__((target("avx2")))
+void op_n_avx2(uint32_t* r, uint32_t const* x, uint32_t mx, uint32_t const* y, uint32_t my, size_t n) {
+    __m256i vmx = _mm256_set1_epi32(static_cast<int>(mx));
+    __m256i vmy = _mm256_set1_epi32(static_cast<int>(my));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(x + i)), vmx);
+        __m256i b = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(y + i)), vmy);
+        __m256i c = MODE == 1 ? _mm256_and_si256(a, b) : MODE == 2 ? _mm256_or_si256(a, b) : _mm256_xor_si256(a, b);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), c);
+    }
+    op_n_scalar<MODE>(r + i, x + i, mx, y + i, my, n - i);
+}
+
+void op_n_avx2(uint32_t* r, uint32_t const* x, uint32_t mx, uint32_t const* y, uint32_t my, size_t n, int mode) {
+    switch (mode) {
+        case 1:
+            return op_n_avx2<1>(r, x, mx, y, my, n);
+        case 2:
+            return op_n_avx2<2>(r, x, mx, y, my, n);
+        default:
+            return op_n_avx2<3>(r, x, mx, y, my, n);
+    }
+}
+
+__attribute__((target("avx2")))
+void xor_n_avx2(uint32_t* r, uint32_t const* x, uint32_t mask, size_t n) {
+    __m256i vmask = _mm256_set1_epi32(static_cast<int>(mask));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(x + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), _mm256_xor_si256(a, vmask));
+    }
+    xor_n_scalar(r + i, x + i, mask, n - i);
+}
+
+template <int MODE>
+__attribute__((target("avx512f")))
+void op_n_avx512(uint32_t* r, uint32_t const* x, uint32_t mx, uint32_t const* y, uint32_t my, size_t n) {
+    __m512i vmx = _mm512_set1_epi32(static_cast<int>(mx));
+    __m512i vmy = _mm512_set1_epi32(static_cast<int>(my));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i a = _mm512_xor_si512(_mm512_loadu_si512(x + i), vmx);
+        __m512i b = _mm512_xor_si512(_mm512_loadu_si512(y + i), vmy);
+        __m512i c = MODE == 1 ? _mm512_and_si512(a, b) : MODE == 2 ? _mm512_or_si512(a, b) : _mm512_xor_si512(a, b);
+        _mm512_storeu_si512(r + i, c);
+    }
+    if (i < n) {
+        __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512i a = _mm512_xor_si512(_mm512_maskz_loadu_epi32(tail, x + i), vmx);
+        __m512i b = _mm512_xor_si512(_mm512_maskz_loadu_epi32(tail, y + i), vmy);
+        __m512i c = MODE == 1 ? _mm512_and_si512(a, b) : MODE == 2 ? _mm512_or_si512(a, b) : _mm512_xor_si512(a, b);
+        _mm512_mask_storeu_epi32(r + i, tail, c);
+    }
+}
+
+void op_n_avx512(uint32_t* r, uint32_t const* x, uint32_t mx, uint32_t const* y, uint32_t my, size_t n, int mode) {
+    switch (mode) {
+        case 1:
+            return op_n_avx512<1>(r, x, mx, y, my, n);
+        case 2:
+            return op_n_avx512<2>(r, x, mx, y, my, n);
+        default:
+            return op_n_avx512<3>(r, x, mx, y, my, n);
+    }
+}
+
+__attribute__((target("avx512f")))
+void xor_n_avx512(uint32_t* r, uint32_t const* x, uint32_t mask, size_t n) {
+    __m512i vmask = _mm512_set1_epi32(static_cast<int>(mask));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_si512(r + i, _mm512_xor_si512(_mm512_loadu_si512(x + i), vmask));
+    }
+    if (i < n) {
+        __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+        _mm512_mask_storeu_epi32(r + i, tail, _mm512_xor_si512(_mm512_maskz_loadu_epi32(tail, x + i), vmask));
+    }
+}
+
+const bitwise_kernels avx2_kernels = {"avx2", op_n_avx2, xor_n_avx2};
+const bitwise_kernels avx512_kernels = {"avx512f", op_n_avx512, xor_n_avx512};
+#endif
+}
+
+bitwise_kernels const& scalar_bitwise_kernels() {
+    return scalar_kernels;
+}
+
+std::vector<bitwise_kernels const*> supported_bitwise_kernels() {
+    std::vector<bitwise_kernels const*> res(1, &scalar_kernels);
+#ifdef BIGINT_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        res.push_back(&avx2_kernels);
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        res.push_back(&avx512_kernels);
+    }
+#endif
+    return res;
+}
+
+bitwise_kernels const& best_bitwise_kernels() {
+    static bitwise_kernels const& best = *supported_bitwise_kernels().back();
+    return best;
+}
@@ -0,0 +1,27 @@
+#ifndef BIGINT_BITWISE_KERNELS_H
+#define BIGINT_BITWISE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Limb kernels behind &, | and ^. Modes match bin_operator: 1 - and, 2 - or, 3 - xor.
+// Operands are xor-ed with a mask first, so ~0 masks give the inverted limbs
+// that make up the two's complement of a negative value.
+struct bitwise_kernels {
+    char const* isa;
+    // r[i] = op(x[i] ^ mx, y[i] ^ my)
+    void (*op_n)(uint32_t* r, uint32_t const* x, uint32_t mx, uint32_t const* y, uint32_t my, size_t n, int mode);
+    // r[i] = x[i] ^ mask, r may be x
+    void (*xor_n)(uint32_t* r, uint32_t const* x, uint32_t mask, size_t n);
+};
+
+bitwise_kernels const& scalar_bitwise_kernels();
+
+// Widest kernels the CPU supports, picked once at first use.
+bitwise_kernels const& best_bitwise_kernels();
+
+// Every set of kernels the CPU supports, scalar first.
+std::vector<bitwise_kernels const*> supported_bitwise_kernels();
+
+#endif //BIGINT_BITWISE_KERNELS_H
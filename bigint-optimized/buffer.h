@@ -1,24 +1,51 @@
 #ifndef BIGINT_BUFFER_H
 #define BIGINT_BUFFER_H
 
+#include <atomic>
 #include "long_buf.h"
+#include "probes.h"
 
-struct buffer {
-    explicit buffer(uint32_t val) : size(1), is_small(true) {
+#ifndef BIGINT_INLINE_LIMBS
+#define BIGINT_INLINE_LIMBS 2
+#endif
+
+struct buffer_stats {
+    size_t spills;   // inline storage outgrown, moved to a long_buf
+    size_t unshares; // shared or viewed limbs deep-copied before a write
+};
+
+template <size_t MAX_SIZE>
+struct basic_buffer {
+    static_assert(MAX_SIZE >= 1, "at least one limb must fit inline");
+
+    explicit basic_buffer(uint32_t val) : size(1), is_small(true), is_view(false) {
         small_data[0] = val;
     }
 
-    buffer(buffer const& a) : size(a.size), is_small(a.is_small) {
+    // Read-only view of limbs owned by someone else, e.g. a memory-mapped file.
+    // The limbs are copied on the first modification, like a shared long_buf.
+    static basic_buffer view(uint32_t const* data, size_t sz) {
+        basic_buffer res(0);
+        res.size = sz;
+        res.is_small = false;
+        res.is_view = true;
+        res.view_data = data;
+        return res;
+    }
+
+    basic_buffer(basic_buffer const& a) : size(a.size), is_small(a.is_small), is_view(a.is_view) {
         if (is_small) {
             std::copy(a.small_data, a.small_data + a.size, small_data);
+        } else if (is_view) {
+            view_data = a.view_data;
         } else {
             long_data = a.long_data;
             long_data->inc_ref();
         }
     }
 
-    ~buffer() {
-        if (!is_small) {
+    ~basic_buffer() {
+        if (!is_small && !is_view) {
             long_data->delete_data();
         }
     }
@@ -35,6 +62,9 @@ struct buffer {
         if (is_small) {
             return small_data[id];
         }
+        if (is_view) {
+            return view_data[id];
+        }
         return (*long_data)[id];
     }
 
@@ -42,6 +72,9 @@ struct buffer {
         if (is_small) {
             return small_data[size - 1];
         }
+        if (is_view) {
+            return view_data[size - 1];
+        }
         return long_data->back();
     }
 
@@ -49,12 +82,32 @@ struct buffer {
         return size;
     }
 
-    buffer& operator=(buffer const& a) {
-        this->~buffer();
+    // Contiguous limbs for tight loops. mutable_limbs unshares once up front,
+    // the pointer stays valid until the next size-changing call.
+    uint32_t* mutable_limbs() {
+        if (is_small) {
+            return small_data;
+        }
+        unshare();
+        return long_data->data();
+    }
+
+    uint32_t const* limbs() const {
+        if (is_small) {
+            return small_data;
+        }
+        return is_view ? view_data : long_data->data();
+    }
+
+    basic_buffer& operator=(basic_buffer const& a) {
+        this->~basic_buffer();
         size = a.size;
         is_small = a.is_small;
+        is_view = a.is_view;
         if (a.is_small) {
             std::copy(a.small_data, a.small_data + a.size, small_data);
+        } else if (a.is_view) {
+            view_data = a.view_data;
         } else {
             long_data = a.long_data;
             long_data->inc_ref();
@@ -65,21 +118,20 @@ struct buffer {
     void push_back(uint32_t a) {
         if (is_small) {
             if (size == MAX_SIZE) {
-                is_small = false;
-                long_data = new long_buf(small_data, MAX_SIZE);
-                long_data->push_back(a);
+                spill(2 * MAX_SIZE);
+                long_data = long_data->push_back(a);
             } else {
                 small_data[size] = a;
             }
         } else {
             unshare();
-            long_data->push_back(a);
+            long_data = long_data->push_back(a);
         }
         size++;
     }
 
     void pop_back() {
-        if (!is_small) {
+        if (!is_small && !is_view) {
             unshare();
             long_data->pop_back();
         }
@@ -87,19 +139,67 @@ struct buffer {
     }
 
     void resize(size_t sz) {
-        if (sz > MAX_SIZE) {
-            is_small = false;
-            if (size <= MAX_SIZE) {
-                std::vector<uint32_t> curr(small_data, small_data + size);
-                curr.resize(sz);
-                long_data = new long_buf(curr);
-            } else {
-                long_data->resize(sz);
+        if (is_small && sz <= MAX_SIZE) {
+            std::fill(small_data + std::min(size, sz), small_data + sz, 0);
+            size = sz;
+            return;
+        }
+        size_t old_size = size;
+        resize_uninitialized(sz);
+        if (sz > old_size) {
+            std::fill(long_data->data() + old_size, long_data->data() + sz, 0);
+        }
+    }
+
+    // Like resize, but new limbs are left indeterminate for the caller to overwrite.
+    void resize_uninitialized(size_t sz) {
+        if (is_small) {
+            if (sz > MAX_SIZE) {
+                spill(sz);
+                long_data = long_data->resize_uninitialized(sz);
             }
+        } else {
+            unshare();
+            long_data = long_data->resize_uninitialized(sz);
         }
         size = sz;
     }
 
+    size_t capacity() const {
+        if (is_small) {
+            return MAX_SIZE;
+        }
+        return is_view ? size : long_data->get_capacity();
+    }
+
+    // Makes room for `cap` limbs, so that growing up to it never reallocates.
+    void reserve(size_t cap) {
+        if (is_small) {
+            if (cap > MAX_SIZE) {
+                spill(cap);
+            }
+            return;
+        }
+        unshare();
+        long_data = long_data->reserve(cap);
+    }
+
+    // Releases unused heap capacity, moving the limbs back inline when they fit.
+    // Shared and viewed limbs are left alone.
+    void shrink_to_fit() {
+        if (is_small || is_view || !long_data->is_unique()) {
+            return;
+        }
+        if (size <= MAX_SIZE) {
+            long_buf* old = long_data;
+            std::copy(old->data(), old->data() + size, small_data);
+            old->delete_data();
+            is_small = true;
+            return;
+        }
+        long_data = long_data->shrink_to_fit();
+    }
+
     void reverse() {
         if (is_small) {
             std::reverse(small_data, small_data + size);
@@ -109,18 +209,87 @@ struct buffer {
         }
     }
 
+    // Copy with its own limbs taken from the current limb_allocator.
+    basic_buffer clone() const {
+        if (is_small) {
+            return *this;
+        }
+        basic_buffer res(0);
+        res.size = size;
+        res.is_small = false;
+        res.long_data = long_buf::create(is_view ? view_data : long_data->data(), size, size);
+        return res;
+    }
+
     void unshare() {
-        long_data = long_data->make_unique_data();
+        if (is_view) {
+            count(unshare_count);
+            BIGINT_PROBE1(unshare__entry, size);
+            instrumentation::record_deep_copy();
+            long_data = long_buf::create(view_data, size, size);
+            is_view = false;
+            BIGINT_PROBE1(unshare__return, size);
+            return;
+        }
+        if (!long_data->is_unique()) {
+            count(unshare_count);
+            BIGINT_PROBE1(unshare__entry, size);
+            long_data = long_data->make_unique_data();
+            BIGINT_PROBE1(unshare__return, size);
+        }
+    }
+
+    // Counted only when built with BIGINT_BUFFER_STATS, zeros otherwise.
+    static buffer_stats stats() {
+        buffer_stats res = {spill_count.load(std::memory_order_relaxed),
+                            unshare_count.load(std::memory_order_relaxed)};
+        return res;
+    }
+
+    static void reset_stats() {
+        spill_count.store(0, std::memory_order_relaxed);
+        unshare_count.store(0, std::memory_order_relaxed);
+    }
+
+    static constexpr size_t inline_capacity() {
+        return MAX_SIZE;
     }
 
 private:
-    static constexpr size_t MAX_SIZE = 2;
+    void spill(size_t cap) {
+        count(spill_count);
+        long_buf* curr = long_buf::create(small_data, size, cap);
+        is_small = false;
+        long_data = curr;
+    }
+
+    static void count(std::atomic<size_t>& counter) {
+#ifdef BIGINT_BUFFER_STATS
+        counter.fetch_add(1, std::memory_order_relaxed);
+#else
+        (void) counter;
+#endif
+    }
+
+    static std::atomic<size_t> spill_count;
+    static std::atomic<size_t> unshare_count;
+
     size_t size;
     bool is_small;
+    bool is_view;
     union {
         uint32_t small_data[MAX_SIZE];
         long_buf* long_data;
+        uint32_t const* view_data;
     };
 };
 
+template <size_t MAX_SIZE>
+std::atomic<size_t> basic_buffer<MAX_SIZE>::spill_count(0);
+
+template <size_t MAX_SIZE>
+std::atomic<size_t> basic_buffer<MAX_SIZE>::unshare_count(0);
+
+typedef basic_buffer<BIGINT_INLINE_LIMBS> buffer;
+
 #endif //BIGINT_BUFFER_H
@@ -0,0 +1,96 @@
+// Measures big_integer with the inline capacity it was built with
+// (BIGINT_INLINE_LIMBS); CMake builds one binary per swept size.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "big_integer.h"
+
+namespace {
+// Operand sizes in limbs: mostly 3-8 limbs, with some small and some larger values.
+size_t draw_limbs(std::mt19937_64& rng) {
+    size_t bucket = rng() % 100;
+    if (bucket < 10) {
+        return 1;
+    }
+    if (bucket < 20) {
+        return 2;
+    }
+    if (bucket < 85) {
+        return 3 + rng() % 6;
+    }
+    return 9 + rng() % 8;
+}
+
+std::vector<big_integer> make_operands(size_t count, std::mt19937_64& rng) {
+    std::vector<big_integer> res;
+    res.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        big_integer a = big_integer::random(32 * draw_limbs(rng), rng) + 1;
+        res.push_back(i % 2 ? -a : a);
+    }
+    return res;
+}
+
+template <typename F>
+void run(char const* name, size_t ops, F&& f) {
+    buffer::reset_stats();
+    auto start = std::chrono::steady_clock::now();
+    size_t checksum = f();
+    auto finish = std::chrono::steady_clock::now();
+    buffer_stats stats = buffer::stats();
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count() / ops;
+    std::cout << buffer::inline_capacity() << ',' << name << ',' << ns << ',' << stats.spills << ','
+              << stats.unshares << ',' << checksum << '\n';
+}
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::mt19937_64 rng(2020);
+    std::vector<big_integer> a = make_operands(count, rng);
+    std::vector<big_integer> b = make_operands(count, rng);
+
+    std::cout << "inline_limbs,workload,ns_per_op,spills,unshares,checksum\n";
+    run("add", count, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += (a[i] + b[i] != 0);
+        }
+        return sum;
+    });
+    run("mul", count, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += (a[i] * b[i] != 0);
+        }
+        return sum;
+    });
+    run("div", count, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += (a[i] * b[i] / b[i] == a[i]);
+        }
+        return sum;
+    });
+    run("copy_modify", count, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            big_integer c = a[i];
+            c += 1;
+            sum += (c != a[i]);
+        }
+        return sum;
+    });
+    run("accumulate", count, [&] {
+        big_integer acc;
+        for (size_t i = 0; i < count; i++) {
+            acc += a[i];
+        }
+        return static_cast<size_t>(acc != 0);
+    });
+    return 0;
+}
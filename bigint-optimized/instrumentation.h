@@ -0,0 +1,143 @@
+#ifndef BIGINT_INSTRUMENTATION_H
+#define BIGINT_INSTRUMENTATION_H
+
+#include <atomic>
+#include <cstddef>
+
+// Process-wide counters of big_integer operations and limb storage traffic,
+// collected only when built with BIGINT_INSTRUMENTATION. Otherwise every
+// record call is an empty inline function and snapshots are all zeros.
+//
+// Operations are counted where their magnitude kernel runs, so a + b with
+// operands of different signs counts as a sub, and a % b as a div, a mul and a sub
+// (long division also counts the scalar multiplications of every quotient limb).
+enum class bigint_op {
+    add,
+    sub,
+    mul,
+    div,
+    scalar,   // operators with a built-in integer operand
+    bitwise,
+    shl,
+    shr,
+    to_string,
+    from_string,
+    count
+};
+
+struct instrumentation_snapshot {
+    static constexpr size_t OPS = static_cast<size_t>(bigint_op::count);
+    // bucket k counts operands of [2^k, 2^(k+1)) limbs, the last one everything larger
+    static constexpr size_t SIZE_BUCKETS = 24;
+
+    size_t calls[OPS];
+    size_t operand_limbs[OPS][SIZE_BUCKETS];
+    size_t allocations;   // long_buf blocks created
+    size_t deep_copies;   // shared or viewed limbs copied before a write
+    size_t reallocations; // blocks moved to grow or shrink
+    size_t bytes_copied;  // limb bytes copied into new blocks
+};
+
+struct instrumentation {
+    static char const* name(bigint_op op) {
+        static char const* const names[] = {"add", "sub", "mul", "div", "scalar", "bitwise",
+                                            "shl", "shr", "to_string", "from_string"};
+        return names[static_cast<size_t>(op)];
+    }
+
+    // Histogram bucket of an operand size.
+    static size_t bucket(size_t limbs) {
+        size_t res = 0;
+        while (limbs > 1 && res + 1 < instrumentation_snapshot::SIZE_BUCKETS) {
+            limbs >>= 1;
+            res++;
+        }
+        return res;
+    }
+
+#ifdef BIGINT_INSTRUMENTATION
+    static constexpr bool enabled = true;
+
+    static void record_op(bigint_op op, size_t limbs) {
+        counters& c = storage();
+        size_t id = static_cast<size_t>(op);
+        c.calls[id].fetch_add(1, std::memory_order_relaxed);
+        c.operand_limbs[id][bucket(limbs)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void record_allocation(size_t bytes_copied) {
+        storage().allocations.fetch_add(1, std::memory_order_relaxed);
+        storage().bytes_copied.fetch_add(bytes_copied, std::memory_order_relaxed);
+    }
+
+    static void record_deep_copy() {
+        storage().deep_copies.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void record_reallocation() {
+        storage().reallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static instrumentation_snapshot snapshot() {
+        counters& c = storage();
+        instrumentation_snapshot res;
+        for (size_t i = 0; i < instrumentation_snapshot::OPS; i++) {
+            res.calls[i] = c.calls[i].load(std::memory_order_relaxed);
+            for (size_t j = 0; j < instrumentation_snapshot::SIZE_BUCKETS; j++) {
+                res.operand_limbs[i][j] = c.operand_limbs[i][j].load(std::memory_order_relaxed);
+            }
+        }
+        res.allocations = c.allocations.load(std::memory_order_relaxed);
+        res.deep_copies = c.deep_copies.load(std::memory_order_relaxed);
+        res.reallocations = c.reallocations.load(std::memory_order_relaxed);
+        res.bytes_copied = c.bytes_copied.load(std::memory_order_relaxed);
+        return res;
+    }
+
+    static void reset() {
+        counters& c = storage();
+        for (size_t i = 0; i < instrumentation_snapshot::OPS; i++) {
+            c.calls[i].store(0, std::memory_order_relaxed);
+            for (size_t j = 0; j < instrumentation_snapshot::SIZE_BUCKETS; j++) {
+                c.operand_limbs[i][j].store(0, std::memory_order_relaxed);
+            }
+        }
+        c.allocations.store(0, std::memory_order_relaxed);
+        c.deep_copies.store(0, std::memory_order_relaxed);
+        c.reallocations.store(0, std::memory_order_relaxed);
+        c.bytes_copied.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct counters {
+        std::atomic<size_t> calls[instrumentation_snapshot::OPS];
+        std::atomic<size_t> operand_limbs[instrumentation_snapshot::OPS][instrumentation_snapshot::SIZE_BUCKETS];
+        std::atomic<size_t> allocations;
+        std::atomic<size_t> deep_copies;
+        std::atomic<size_t> reallocations;
+        std::atomic<size_t> bytes_copied;
+    };
+
+    // zero-initialized as a static
+    static counters& storage() {
+        static counters c;
+        return c;
+    }
+#else
+    static constexpr bool enabled = false;
+
+    static void record_op(bigint_op, size_t) {}
+    static void record_allocation(size_t) {}
+    static void record_deep_copy() {}
+    static void record_reallocation() {}
+
+    static instrumentation_snapshot snapshot() {
+        instrumentation_snapshot res = {};
+        return res;
+    }
+
+    static void reset() {}
+#endif
+};
+
+#endif //BIGINT_INSTRUMENTATION_H
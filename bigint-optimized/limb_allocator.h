@@ -0,0 +1,278 @@
+#ifndef BIGINT_LIMB_ALLOCATOR_H
+#define BIGINT_LIMB_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Source of long_buf blocks. Every block remembers the allocator it came from
+// and is returned to it, whichever allocator is current at that moment.
+struct limb_allocator {
+    virtual ~limb_allocator() = default;
+    virtual void* allocate(size_t bytes) = 0;
+    virtual void deallocate(void* p, size_t bytes) = 0;
+
+    // Usable size of a block requested with `bytes`, lets long_buf use the slack.
+    virtual size_t good_size(size_t bytes) const {
+        return bytes;
+    }
+};
+
+struct heap_limb_allocator : limb_allocator {
+    void* allocate(size_t bytes) override {
+        return ::operator new(bytes);
+    }
+
+    void deallocate(void* p, size_t) override {
+        ::operator delete(p);
+    }
+};
+
+inline limb_allocator& heap_allocator() {
+    static heap_limb_allocator heap;
+    return heap;
+}
+
+struct free_list_stats {
+    size_t hits;           // allocations served from a free list
+    size_t misses;         // allocations that went to the heap
+    size_t retained_bytes; // bytes currently cached in the free lists
+};
+
+// Per-thread free lists of recently released blocks, one list per power-of-two
+// block size. A block is cached by the thread that frees it, whichever thread
+// allocated it. Blocks above MAX_CLASS bytes bypass the cache.
+struct free_list_limb_allocator : limb_allocator {
+    static constexpr size_t MIN_CLASS = 6;
+    static constexpr size_t MAX_CLASS = 20;
+    static constexpr size_t MAX_RETAINED_PER_CLASS = 1 << 20;
+
+    void* allocate(size_t bytes) override {
+        size_t cls = size_class(bytes);
+        cache* c = thread_cache();
+        if (cls > MAX_CLASS || c == nullptr) {
+            return ::operator new(cls > MAX_CLASS ? bytes : static_cast<size_t>(1) << cls);
+        }
+        node*& head = c->lists[cls];
+        if (head != nullptr) {
+            node* res = head;
+            head = head->next;
+            c->retained[cls] -= static_cast<size_t>(1) << cls;
+            c->stats.retained_bytes -= static_cast<size_t>(1) << cls;
+            c->stats.hits++;
+            return res;
+        }
+        c->stats.misses++;
+        return ::operator new(static_cast<size_t>(1) << cls);
+    }
+
+    void deallocate(void* p, size_t bytes) override {
+        size_t cls = size_class(bytes);
+        cache* c = thread_cache();
+        if (cls > MAX_CLASS || c == nullptr || c->retained[cls] >= MAX_RETAINED_PER_CLASS) {
+            ::operator delete(p);
+            return;
+        }
+        node* n = static_cast<node*>(p);
+        n->next = c->lists[cls];
+        c->lists[cls] = n;
+        c->retained[cls] += static_cast<size_t>(1) << cls;
+        c->stats.retained_bytes += static_cast<size_t>(1) << cls;
+    }
+
+    size_t good_size(size_t bytes) const override {
+        size_t cls = size_class(bytes);
+        return cls > MAX_CLASS ? bytes : static_cast<size_t>(1) << cls;
+    }
+
+    // Counters of the calling thread.
+    static free_list_stats thread_stats() {
+        cache* c = thread_cache();
+        free_list_stats empty = {0, 0, 0};
+        return c != nullptr ? c->stats : empty;
+    }
+
+    // Returns the cached blocks of the calling thread to the heap and resets its counters.
+    static void trim() {
+        cache* c = thread_cache();
+        if (c != nullptr) {
+            c->clear();
+        }
+    }
+
+private:
+    struct node {
+        node* next;
+    };
+
+    struct cache {
+        node* lists[MAX_CLASS + 1];
+        size_t retained[MAX_CLASS + 1];
+        free_list_stats stats;
+
+        cache() {
+            std::fill(lists, lists + MAX_CLASS + 1, nullptr);
+            std::fill(retained, retained + MAX_CLASS + 1, 0);
+            stats.hits = stats.misses = stats.retained_bytes = 0;
+        }
+
+        ~cache() {
+            clear();
+            destroyed() = true;
+        }
+
+        void clear() {
+            for (size_t i = 0; i <= MAX_CLASS; i++) {
+                while (lists[i] != nullptr) {
+                    node* next = lists[i]->next;
+                    ::operator delete(lists[i]);
+                    lists[i] = next;
+                }
+                retained[i] = 0;
+            }
+            stats.hits = stats.misses = stats.retained_bytes = 0;
+        }
+    };
+
+    // Trivially destructible, so it stays valid while other thread_local and
+    // static objects holding big_integers are destroyed after the cache.
+    static bool& destroyed() {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    static cache* thread_cache() {
+        if (destroyed()) {
+            return nullptr;
+        }
+        static thread_local cache c;
+        return &c;
+    }
+
+    static size_t size_class(size_t bytes) {
+        size_t cls = MIN_CLASS;
+        while ((static_cast<size_t>(1) << cls) < bytes) {
+            cls++;
+        }
+        return cls;
+    }
+};
+
+inline limb_allocator& free_list_allocator() {
+    static free_list_limb_allocator free_lists;
+    return free_lists;
+}
+
+inline limb_allocator*& current_allocator_slot() {
+    static thread_local limb_allocator* current = nullptr;
+    return current;
+}
+
+// Allocator used for new blocks on this thread. The global heap by default,
+// the thread-local free lists when built with BIGINT_FREE_LISTS.
+inline limb_allocator& current_limb_allocator() {
+    limb_allocator* current = current_allocator_slot();
+#ifdef BIGINT_FREE_LISTS
+    return current != nullptr ? *current : free_list_allocator();
+#else
+    return current != nullptr ? *current : heap_allocator();
+#endif
+}
+
+// Makes `alloc` the current allocator of this thread until the end of the scope.
+struct scoped_limb_allocator {
+    explicit scoped_limb_allocator(limb_allocator& alloc) : previous(current_allocator_slot()) {
+        current_allocator_slot() = &alloc;
+    }
+
+    ~scoped_limb_allocator() {
+        current_allocator_slot() = previous;
+    }
+
+    scoped_limb_allocator(scoped_limb_allocator const&) = delete;
+    scoped_limb_allocator& operator=(scoped_limb_allocator const&) = delete;
+
+private:
+    limb_allocator* previous;
+};
+
+// Bump allocator: blocks are carved out of large chunks and all of them are
+// released at once by reset(), release() or the destructor. Freeing the most recent
+// block rolls the bump pointer back, so short-lived temporaries are reused.
+// Values whose limbs live in an arena must not outlive it, use
+// big_integer::deep_copy outside of the arena scope to keep a result.
+struct arena_allocator : limb_allocator {
+    explicit arena_allocator(size_t chunk_size = 64 * 1024, limb_allocator& upstream = heap_allocator())
+            : chunk_size(chunk_size), upstream(upstream), pos(nullptr), end(nullptr), total(0) {}
+
+    ~arena_allocator() override {
+        release();
+    }
+
+    arena_allocator(arena_allocator const&) = delete;
+    arena_allocator& operator=(arena_allocator const&) = delete;
+
+    void* allocate(size_t bytes) override {
+        bytes = align(bytes);
+        if (static_cast<size_t>(end - pos) < bytes) {
+            size_t sz = std::max(bytes, chunk_size);
+            chunks.push_back(chunk(static_cast<char*>(upstream.allocate(sz)), sz));
+            pos = chunks.back().first;
+            end = pos + sz;
+        }
+        void* res = pos;
+        pos += bytes;
+        total += bytes;
+        return res;
+    }
+
+    void deallocate(void* p, size_t bytes) override {
+        if (static_cast<char*>(p) + align(bytes) == pos) {
+            pos = static_cast<char*>(p);
+        }
+    }
+
+    // Drops every block at once but keeps the first chunk for the next round.
+    void reset() {
+        if (chunks.empty()) {
+            return;
+        }
+        for (size_t i = 1; i < chunks.size(); i++) {
+            upstream.deallocate(chunks[i].first, chunks[i].second);
+        }
+        chunks.resize(1);
+        pos = chunks[0].first;
+        end = pos + chunks[0].second;
+    }
+
+    void release() {
+        for (size_t i = 0; i < chunks.size(); i++) {
+            upstream.deallocate(chunks[i].first, chunks[i].second);
+        }
+        chunks.clear();
+        pos = end = nullptr;
+    }
+
+    // Bytes handed out since construction, including reused ones.
+    size_t bytes_allocated() const {
+        return total;
+    }
+
+private:
+    typedef std::pair<char*, size_t> chunk;
+
+    static size_t align(size_t bytes) {
+        return (bytes + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    }
+
+    size_t chunk_size;
+    limb_allocator& upstream;
+    std::vector<chunk> chunks;
+    char* pos;
+    char* end;
+    size_t total;
+};
+
+#endif //BIGINT_LIMB_ALLOCATOR_H
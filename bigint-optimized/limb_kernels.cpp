@@ -0,0 +1,278 @@
+#include "limb_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BIGINT_X86_64_ASM
+#endif
+
+#ifdef BIGINT_ASM_KERNELS
+#include "long_arith.h"
+#endif
+
+namespace {
+uint32_t add_n_portable(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t sum = static_cast<uint64_t>(x[i]) + y[i] + carry;
+        r[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+uint32_t sub_n_portable(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t diff = static_cast<uint64_t>(x[i]) - y[i] - borrow;
+        r[i] = static_cast<uint32_t>(diff);
+        borrow = (diff >> 32) != 0;
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+uint32_t mul_1_portable(uint32_t* r, uint32_t const* x, size_t n, uint32_t m) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t curr = static_cast<uint64_t>(x[i]) * m + carry;
+        r[i] = static_cast<uint32_t>(curr);
+        carry = curr >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+uint32_t addmul_1_portable(uint32_t* r, uint32_t const* x, size_t n, uint32_t m) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t curr = static_cast<uint64_t>(x[i]) * m + r[i] + carry;
+        r[i] = static_cast<uint32_t>(curr);
+        carry = curr >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+const limb_kernels portable_kernels = {"portable", add_n_portable, sub_n_portable, mul_1_portable, addmul_1_portable};
+
+#ifdef BIGINT_X86_64_ASM
+// The loops below walk pairs of limbs as 64-bit words and keep the carry in
+// the flags for the whole pass; an odd last limb is finished in C++.
+
+uint32_t add_n_adc(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n) {
+    size_t q = n / 2;
+    uint64_t carry = 0;
+    if (q != 0) {
+        uint32_t* rp = r;
+        uint32_t const* xp = x;
+        uint32_t const* yp = y;
+        uint64_t tmp;
+        __asm__ volatile(
+            "clc\n\t"
+            "1:\n\t"
+            "movq (%[x]), %[tmp]\n\t"
+            "adcq (%[y]), %[tmp]\n\t"
+            "movq %[tmp], (%[r])\n\t"
+            "leaq 8(%[x]), %[x]\n\t"
+            "leaq 8(%[y]), %[y]\n\t"
+            "leaq 8(%[r]), %[r]\n\t"
+            "decq %[q]\n\t"
+            "jnz 1b\n\t"
+            "setc %b[carry]\n\t"
+            : [r] "+r"(rp), [x] "+r"(xp), [y] "+r"(yp), [q] "+r"(q), [tmp] "=&r"(tmp), [carry] "+r"(carry)
+            :
+            : "cc", "memory");
+    }
+    if (n % 2 != 0) {
+        uint64_t sum = static_cast<uint64_t>(x[n - 1]) + y[n - 1] + carry;
+        r[n - 1] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+uint32_t sub_n_sbb(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n) {
+    size_t q = n / 2;
+    uint64_t borrow = 0;
+    if (q != 0) {
+        uint32_t* rp = r;
+        uint32_t const* xp = x;
+        uint32_t const* yp = y;
+        uint64_t tmp;
+        __asm__ volatile(
+            "clc\n\t"
+            "1:\n\t"
+            "movq (%[x]), %[tmp]\n\t"
+            "sbbq (%[y]), %[tmp]\n\t"
+            "movq %[tmp], (%[r])\n\t"
+            "leaq 8(%[x]), %[x]\n\t"
+            "leaq 8(%[y]), %[y]\n\t"
+            "leaq 8(%[r]), %[r]\n\t"
+            "decq %[q]\n\t"
+            "jnz 1b\n\t"
+            "setc %b[borrow]\n\t"
+            : [r] "+r"(rp), [x] "+r"(xp), [y] "+r"(yp), [q] "+r"(q), [tmp] "=&r"(tmp), [borrow] "+r"(borrow)
+            :
+            : "cc", "memory");
+    }
+    if (n % 2 != 0) {
+        uint64_t diff = static_cast<uint64_t>(x[n - 1]) - y[n - 1] - borrow;
+        r[n - 1] = static_cast<uint32_t>(diff);
+        borrow = (diff >> 32) != 0;
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+// mulx leaves the flags alone, so the carry of the low halves runs through CF (adcx).
+uint32_t mul_1_mulx(uint32_t* r, uint32_t const* x, size_t n, uint32_t m) {
+    size_t q = n / 2;
+    uint64_t carry = 0;
+    if (q != 0) {
+        uint32_t* rp = r;
+        uint32_t const* xp = x;
+        uint64_t lo, hi;
+        __asm__ volatile(
+            "xorl %k[lo], %k[lo]\n\t"
+            "1:\n\t"
+            "mulxq (%[x]), %[lo], %[hi]\n\t"
+            "adcxq %[carry], %[lo]\n\t"
+            "movq %[lo], (%[r])\n\t"
+            "movq %[hi], %[carry]\n\t"
+            "leaq 8(%[x]), %[x]\n\t"
+            "leaq 8(%[r]), %[r]\n\t"
+            "decq %[q]\n\t"
+            "jnz 1b\n\t"
+            "movl $0, %k[lo]\n\t"
+            "adcxq %[lo], %[carry]\n\t"
+            : [r] "+r"(rp), [x] "+r"(xp), [q] "+r"(q), [lo] "=&r"(lo), [hi] "=&r"(hi), [carry] "+r"(carry)
+            : "d"(static_cast<uint64_t>(m))
+            : "cc", "memory");
+    }
+    if (n % 2 != 0) {
+        uint64_t curr = static_cast<uint64_t>(x[n - 1]) * m + carry;
+        r[n - 1] = static_cast<uint32_t>(curr);
+        carry = curr >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+// Two independent carry chains: the product carries through CF (adcx), the
+// addition of r through OF (adox). dec would clobber OF, hence lea and jrcxz.
+uint32_t addmul_1_adx(uint32_t* r, uint32_t const* x, size_t n, uint32_t m) {
+    size_t q = n / 2;
+    uint64_t carry = 0;
+    if (q != 0) {
+        uint32_t* rp = r;
+        uint32_t const* xp = x;
+        uint64_t lo, hi;
+        __asm__ volatile(
+            "xorl %k[lo], %k[lo]\n\t"
+            "1:\n\t"
+            "mulxq (%[x]), %[lo], %[hi]\n\t"
+            "adcxq %[carry], %[lo]\n\t"
+            "adoxq (%[r]), %[lo]\n\t"
+            "movq %[lo], (%[r])\n\t"
+            "movq %[hi], %[carry]\n\t"
+            "leaq 8(%[x]), %[x]\n\t"
+            "leaq 8(%[r]), %[r]\n\t"
+            "leaq -1(%[q]), %[q]\n\t"
+            "jrcxz 2f\n\t"
+            "jmp 1b\n\t"
+            "2:\n\t"
+            "movl $0, %k[lo]\n\t"
+            "adcxq %[lo], %[carry]\n\t"
+            "adoxq %[lo], %[carry]\n\t"
+            : [r] "+r"(rp), [x] "+r"(xp), [q] "+c"(q), [lo] "=&r"(lo), [hi] "=&r"(hi), [carry] "+r"(carry)
+            : "d"(static_cast<uint64_t>(m))
+            : "cc", "memory");
+    }
+    if (n % 2 != 0) {
+        uint64_t curr = static_cast<uint64_t>(x[n - 1]) * m + r[n - 1] + carry;
+        r[n - 1] = static_cast<uint32_t>(curr);
+        carry = curr >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+#ifdef BIGINT_ASM_KERNELS
+// Wrappers over the in-place qword routines of asm/long_arith.asm.
+
+uint64_t* qwords(uint32_t* x) {
+    return reinterpret_cast<uint64_t*>(x);
+}
+
+void copy_limbs(uint32_t* r, uint32_t const* x, size_t n) {
+    if (r != x && n != 0) {
+        std::memcpy(r, x, n * sizeof(uint32_t));
+    }
+}
+
+uint32_t add_n_asm(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n) {
+    if (r == y) {
+        std::swap(x, y);
+    }
+    copy_limbs(r, x, n);
+    uint64_t carry = asm_add_long_long(qwords(r), reinterpret_cast<uint64_t const*>(y), n / 2);
+    if (n % 2 != 0) {
+        uint64_t sum = static_cast<uint64_t>(r[n - 1]) + y[n - 1] + carry;
+        r[n - 1] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+uint32_t sub_n_asm(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n) {
+    if (r == y && r != x) {
+        return sub_n_portable(r, x, y, n);
+    }
+    copy_limbs(r, x, n);
+    uint64_t borrow = asm_sub_long_long(qwords(r), reinterpret_cast<uint64_t const*>(y), n / 2);
+    if (n % 2 != 0) {
+        uint64_t diff = static_cast<uint64_t>(r[n - 1]) - y[n - 1] - borrow;
+        r[n - 1] = static_cast<uint32_t>(diff);
+        borrow = (diff >> 32) != 0;
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+uint32_t mul_1_asm(uint32_t* r, uint32_t const* x, size_t n, uint32_t m) {
+    copy_limbs(r, x, n);
+    uint64_t carry = asm_mul_long_short(qwords(r), n / 2, m);
+    if (n % 2 != 0) {
+        uint64_t curr = static_cast<uint64_t>(r[n - 1]) * m + carry;
+        r[n - 1] = static_cast<uint32_t>(curr);
+        carry = curr >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+const limb_kernels asm_kernels = {"asm", add_n_asm, sub_n_asm, mul_1_asm, addmul_1_portable};
+#endif
+
+const limb_kernels adc_kernels = {"adc", add_n_adc, sub_n_sbb, mul_1_portable, addmul_1_portable};
+const limb_kernels adx_kernels = {"adx", add_n_adc, sub_n_sbb, mul_1_mulx, addmul_1_adx};
+#endif
+}
+
+limb_kernels const& portable_limb_kernels() {
+    return portable_kernels;
+}
+
+std::vector<limb_kernels const*> supported_limb_kernels() {
+    std::vector<limb_kernels const*> res(1, &portable_kernels);
+#ifdef BIGINT_X86_64_ASM
+    res.push_back(&adc_kernels);
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx")) {
+        res.push_back(&adx_kernels);
+    }
+#endif
+#ifdef BIGINT_ASM_KERNELS
+    res.push_back(&asm_kernels);
+#endif
+    return res;
+}
+
+limb_kernels const& best_limb_kernels() {
+    static limb_kernels const& best = *supported_limb_kernels().back();
+    return best;
+}
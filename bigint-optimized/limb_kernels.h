@@ -0,0 +1,31 @@
+#ifndef BIGINT_LIMB_KERNELS_H
+#define BIGINT_LIMB_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Carry-chain kernels on n-limb arrays, the inner loops of +, - and *.
+// r may be equal to x (and to y for add_n/sub_n), but must not partially overlap them.
+struct limb_kernels {
+    char const* isa;
+    // r = x + y, returns the carry
+    uint32_t (*add_n)(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n);
+    // r = x - y, returns the borrow
+    uint32_t (*sub_n)(uint32_t* r, uint32_t const* x, uint32_t const* y, size_t n);
+    // r = x * m, returns the high limb
+    uint32_t (*mul_1)(uint32_t* r, uint32_t const* x, size_t n, uint32_t m);
+    // r += x * m, returns the high limb
+    uint32_t (*addmul_1)(uint32_t* r, uint32_t const* x, size_t n, uint32_t m);
+};
+
+limb_kernels const& portable_limb_kernels();
+
+// Fastest kernels the CPU supports, picked once at first use. Builds with
+// BIGINT_ASM_KERNELS use the routines of asm/long_arith.asm instead.
+limb_kernels const& best_limb_kernels();
+
+// Every set of kernels the CPU supports, portable first.
+std::vector<limb_kernels const*> supported_limb_kernels();
+
+#endif //BIGINT_LIMB_KERNELS_H
@@ -4,27 +4,73 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-
+#include <atomic>
+#include <cstring>
+#include <new>
+#include "instrumentation.h"
+#include "limb_allocator.h"
+
+// Reference counted limb block: the header and the limbs live in one allocation,
+// the limbs start right after the header. Operations that may need more room
+// return the (possibly relocated) block. New blocks come from the current
+// limb_allocator of the thread and go back to the one they came from.
+//
+// With BIGINT_ATOMIC_REFCOUNT the reference counter is atomic, so copies of
+// one big_integer may be shared and released by different threads.
 struct long_buf {
-    long_buf(std::vector<uint32_t> a) : ref_counter(1), v(a) {}
-
-    long_buf(long_buf &a) : ref_counter(1), v(a.v) {}
-
-    long_buf(uint32_t a[], size_t sz) : ref_counter(1), v(a, a + sz) {}
+#ifdef BIGINT_ATOMIC_REFCOUNT
+    static constexpr bool atomic_refcount = true;
+#else
+    static constexpr bool atomic_refcount = false;
+#endif
+
+    static long_buf* create(uint32_t const* a, size_t sz, size_t capacity) {
+        capacity = std::max(capacity, sz);
+        limb_allocator& alloc = current_limb_allocator();
+        capacity = (alloc.good_size(bytes(capacity)) - sizeof(long_buf)) / sizeof(uint32_t);
+        void* mem = alloc.allocate(bytes(capacity));
+        long_buf* res = new (mem) long_buf(sz, capacity, alloc);
+        if (sz != 0) {
+            std::memcpy(res->data(), a, sz * sizeof(uint32_t));
+        }
+        instrumentation::record_allocation(sz * sizeof(uint32_t));
+        return res;
+    }
 
-    ~long_buf() = default;
+    long_buf(long_buf const&) = delete;
+    long_buf& operator=(long_buf const&) = delete;
 
     long_buf* make_unique_data() {
-        if (ref_counter == 1) {
+        if (is_unique()) {
             return this;
         }
-        ref_counter--;
-        return new long_buf(*this);
+        instrumentation::record_deep_copy();
+        long_buf* copy = create(data(), size, capacity);
+        delete_data();
+        return copy;
     }
 
+#ifdef BIGINT_ATOMIC_REFCOUNT
+    void delete_data() {
+        // release publishes our writes to whoever frees the data,
+        // acquire makes the writes of all previous owners visible before delete
+        if (ref_counter.fetch_sub(1, std::memory_order_release) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            destroy();
+        }
+    }
+
+    void inc_ref() {
+        ref_counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool is_unique() const {
+        return ref_counter.load(std::memory_order_acquire) == 1;
+    }
+#else
     void delete_data() {
         if (ref_counter == 1) {
-            delete this;
+            destroy();
         } else {
             ref_counter--;
         }
@@ -34,33 +80,115 @@ struct long_buf {
         ref_counter++;
     }
 
+    bool is_unique() const {
+        return ref_counter == 1;
+    }
+#endif
+
+    uint32_t* data() {
+        return reinterpret_cast<uint32_t*>(this + 1);
+    }
+
+    uint32_t const* data() const {
+        return reinterpret_cast<uint32_t const*>(this + 1);
+    }
+
     uint32_t& operator[](size_t id) {
-        return v[id];
+        return data()[id];
+    }
+
+    uint32_t const& operator[](size_t id) const {
+        return data()[id];
     }
 
     uint32_t const& back() const {
-        return v.back();
+        return data()[size - 1];
     }
 
-    void push_back(uint32_t val) {
-        v.push_back(val);
+    size_t get_capacity() const {
+        return capacity;
+    }
+
+    // The mutating operations below expect a unique block.
+    long_buf* push_back(uint32_t val) {
+        long_buf* res = this;
+        if (size == capacity) {
+            res = relocate(std::max<size_t>(capacity * 2, 4));
+        }
+        res->data()[res->size++] = val;
+        return res;
     }
 
     void pop_back() {
-        v.pop_back();
+        size--;
     }
 
     void reverse() {
-        std::reverse(v.begin(), v.end());
+        std::reverse(data(), data() + size);
+    }
+
+    long_buf* resize(size_t sz) {
+        size_t old_size = size;
+        long_buf* res = resize_uninitialized(sz);
+        if (sz > old_size) {
+            std::fill(res->data() + old_size, res->data() + sz, 0);
+        }
+        return res;
+    }
+
+    // New limbs are left indeterminate, the caller overwrites them.
+    long_buf* resize_uninitialized(size_t sz) {
+        long_buf* res = this;
+        if (sz > capacity) {
+            res = relocate(std::max(sz, capacity * 2));
+        }
+        res->size = sz;
+        return res;
+    }
+
+    long_buf* reserve(size_t cap) {
+        return cap > capacity ? relocate(cap) : this;
     }
 
-    void resize(size_t sz) {
-        v.resize(sz);
+    long_buf* shrink_to_fit() {
+        return good_capacity(size) < capacity ? relocate(size) : this;
     }
 
 private:
+    long_buf(size_t sz, size_t cap, limb_allocator& alloc) : ref_counter(1), size(sz), capacity(cap), alloc(&alloc) {}
+
+    ~long_buf() = default;
+
+    static size_t bytes(size_t capacity) {
+        return sizeof(long_buf) + capacity * sizeof(uint32_t);
+    }
+
+    void destroy() {
+        limb_allocator* owner = alloc;
+        size_t sz = bytes(capacity);
+        this->~long_buf();
+        owner->deallocate(this, sz);
+    }
+
+    size_t good_capacity(size_t cap) const {
+        return (alloc->good_size(bytes(cap)) - sizeof(long_buf)) / sizeof(uint32_t);
+    }
+
+    long_buf* relocate(size_t new_capacity) {
+        instrumentation::record_reallocation();
+        long_buf* res = create(data(), size, new_capacity);
+        destroy();
+        return res;
+    }
+
+#ifdef BIGINT_ATOMIC_REFCOUNT
+    std::atomic<size_t> ref_counter;
+#else
     size_t ref_counter;
-    std::vector<uint32_t> v;
+#endif
+    size_t size;
+    size_t capacity;
+    limb_allocator* alloc;
 };
 
 #endif //BIGINT_LONG_BUF_H
@@ -0,0 +1,123 @@
+#include "mapped_array.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "mapped_big_integer_array reads limbs in place and needs a little-endian host"
+#endif
+
+namespace {
+const char MAGIC[8] = {'B', 'I', 'G', 'A', 'R', 'R', '0', '1'};
+const size_t HEADER_SIZE = 16;
+
+// Offsets start at 0 and grow by at least one limb per value up to the payload size,
+// and every value is normalized: no zero top limb, zero is a single unsigned limb.
+bool valid_index(uint64_t const* index, uint32_t const* limbs, size_t count, size_t payload_limbs) {
+    if ((index[0] >> 1) != 0 || (index[count] >> 1) != payload_limbs) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint64_t begin = index[i] >> 1;
+        uint64_t end = index[i + 1] >> 1;
+        if (end <= begin) {
+            return false;
+        }
+        if (limbs[end - 1] == 0 && (end - begin != 1 || (index[i] & 1) != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+void write_big_integer_array(std::string const& path, std::vector<big_integer> const& values) {
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    uint64_t count = values.size();
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<char const*>(&count), sizeof(count));
+
+    uint64_t offset = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        uint64_t entry = (offset << 1) | (values[i].sign ? 1 : 0);
+        out.write(reinterpret_cast<char const*>(&entry), sizeof(entry));
+        offset += values[i].size();
+    }
+    uint64_t last = offset << 1;
+    out.write(reinterpret_cast<char const*>(&last), sizeof(last));
+
+    std::vector<uint32_t> limbs;
+    for (size_t i = 0; i < values.size(); i++) {
+        limbs.resize(values[i].size());
+        for (size_t j = 0; j < limbs.size(); j++) {
+            limbs[j] = values[i][j];
+        }
+        out.write(reinterpret_cast<char const*>(limbs.data()), limbs.size() * sizeof(uint32_t));
+    }
+    out.flush();
+    if (!out) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+}
+
+mapped_big_integer_array::mapped_big_integer_array(std::string const& path) : data(nullptr), length(0), count(0),
+                                                                               index(nullptr), limbs(nullptr) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        throw std::system_error(err, std::generic_category(), path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length < HEADER_SIZE + sizeof(uint64_t)) {
+        close(fd);
+        throw std::runtime_error(path + ": not a big_integer array");
+    }
+    data = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::system_error(err, std::generic_category(), path);
+    }
+
+    char const* bytes = static_cast<char const*>(data);
+    std::memcpy(&count, bytes + sizeof(MAGIC), sizeof(count));
+    index = reinterpret_cast<uint64_t const*>(bytes + HEADER_SIZE);
+    size_t payload = HEADER_SIZE + (count + 1) * sizeof(uint64_t);
+    bool valid = std::memcmp(bytes, MAGIC, sizeof(MAGIC)) == 0 &&
+                 count < (length - HEADER_SIZE) / sizeof(uint64_t) &&
+                 valid_index(index, reinterpret_cast<uint32_t const*>(bytes + payload), count,
+                             (length - payload) / sizeof(uint32_t));
+    if (!valid) {
+        munmap(data, length);
+        throw std::runtime_error(path + ": not a big_integer array");
+    }
+    limbs = reinterpret_cast<uint32_t const*>(bytes + payload);
+}
+
+mapped_big_integer_array::~mapped_big_integer_array() {
+    munmap(data, length);
+}
+
+size_t mapped_big_integer_array::size() const {
+    return count;
+}
+
+big_integer mapped_big_integer_array::operator[](size_t id) const {
+    uint64_t begin = index[id] >> 1;
+    uint64_t end = index[id + 1] >> 1;
+    return big_integer(buffer::view(limbs + begin, end - begin), (index[id] & 1) != 0);
+}
@@ -0,0 +1,36 @@
+#ifndef BIGINT_MAPPED_ARRAY_H
+#define BIGINT_MAPPED_ARRAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "big_integer.h"
+
+// On-disk array of big integers, all fields little-endian:
+//   header  "BIGARR01", uint64 count
+//   index   count + 1 uint64 entries (limb_offset << 1 | sign), the last one holds the total limb count
+//   payload packed uint32 limbs, at least one per value, no zero top limb and no negative zero
+void write_big_integer_array(std::string const& path, std::vector<big_integer> const& values);
+
+// Read-only memory mapping of a file produced by write_big_integer_array.
+// Elements are big_integer views reading limbs straight from the page cache;
+// they are copied only when modified and must not outlive the mapping.
+struct mapped_big_integer_array {
+    explicit mapped_big_integer_array(std::string const& path);
+    ~mapped_big_integer_array();
+
+    mapped_big_integer_array(mapped_big_integer_array const&) = delete;
+    mapped_big_integer_array& operator=(mapped_big_integer_array const&) = delete;
+
+    size_t size() const;
+    big_integer operator[](size_t id) const;
+
+private:
+    void* data;
+    size_t length;
+    size_t count;
+    uint64_t const* index;
+    uint32_t const* limbs;
+};
+
+#endif //BIGINT_MAPPED_ARRAY_H
@@ -0,0 +1,212 @@
+// Times every operator and conversion of one big integer implementation and of
+// big_integer_gmp on random operands from 1 to 10^6 limbs. CMake builds it once
+// against bigint-optimized (buffer-backed) and once against bigint (vector-backed,
+// with BIGINT_VECTOR).
+//
+// usage: operator_benchmark [--json] [--max-limbs N] [--budget-ms MS]
+// Every measurement repeats the operation for at least half of MS milliseconds.
+// An operation slower than MS is not measured on larger operands (parsing stops
+// together with printing, which supplies its input), and the sweep stops once
+// building the operands alone takes longer than 20 budgets.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef BIGINT_VECTOR
+#include "../bigint/big_integer.h"
+#else
+#include "big_integer.h"
+#endif
+#include "big_integer_gmp.h"
+
+namespace {
+#ifdef BIGINT_VECTOR
+char const* const IMPL = "vector";
+
+// Horner over random limbs, the public interface offers nothing faster.
+big_integer make_operand(size_t limbs, std::mt19937_64& rng) {
+    big_integer res;
+    for (size_t i = 0; i < limbs; i++) {
+        res = (res << 32) + big_integer(static_cast<uint32_t>(rng()));
+    }
+    return rng() % 2 ? -res : res;
+}
+#else
+char const* const IMPL = "buffer";
+
+big_integer make_operand(size_t limbs, std::mt19937_64& rng) {
+    big_integer res = big_integer::random(32 * limbs, rng);
+    return rng() % 2 ? -res : res;
+}
+#endif
+
+big_integer_gmp make_gmp_operand(size_t limbs, std::mt19937_64& rng) {
+    big_integer_gmp res;
+    res.random(32 * limbs, rng);
+    return res;
+}
+
+struct options {
+    bool json = false;
+    size_t max_limbs = 1000000;
+    double budget_ns = 1e8;
+};
+
+struct result {
+    std::string op;
+    size_t limbs;
+    double ns;
+    double gmp_ns;
+};
+
+volatile size_t sink;
+
+// Average time of f, with the repetitions doubled until they fill half the budget.
+double measure(std::function<size_t()> const& f, double budget_ns) {
+    for (size_t iterations = 1;; iterations *= 2) {
+        size_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            checksum += f();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        sink = checksum;
+        if (ns * 2 >= budget_ns) {
+            return ns / iterations;
+        }
+    }
+}
+
+template <typename T>
+struct operands {
+    T a, b, wide, small;
+    int shift;
+    std::string decimal;
+};
+
+template <typename T>
+std::vector<std::pair<char const*, std::function<size_t()>>> operations(operands<T> const& o) {
+    typedef std::function<size_t()> op;
+    std::vector<std::pair<char const*, op>> res;
+    res.emplace_back("add", op([&o] { return static_cast<size_t>(o.a + o.b != 0); }));
+    res.emplace_back("sub", op([&o] { return static_cast<size_t>(o.a - o.b != 0); }));
+    res.emplace_back("mul", op([&o] { return static_cast<size_t>(o.a * o.b != 0); }));
+    res.emplace_back("div", op([&o] { return static_cast<size_t>(o.wide / o.b != 0); }));
+    res.emplace_back("mod", op([&o] { return static_cast<size_t>(o.wide % o.b != 0); }));
+    res.emplace_back("mul_small", op([&o] { return static_cast<size_t>(o.a * o.small != 0); }));
+    res.emplace_back("div_small", op([&o] { return static_cast<size_t>(o.a / o.small != 0); }));
+    res.emplace_back("and", op([&o] { return static_cast<size_t>((o.a & o.b) != 0); }));
+    res.emplace_back("or", op([&o] { return static_cast<size_t>((o.a | o.b) != 0); }));
+    res.emplace_back("xor", op([&o] { return static_cast<size_t>((o.a ^ o.b) != 0); }));
+    res.emplace_back("not", op([&o] { return static_cast<size_t>(~o.a != 0); }));
+    res.emplace_back("neg", op([&o] { return static_cast<size_t>(-o.a != 0); }));
+    res.emplace_back("shl", op([&o] { return static_cast<size_t>((o.a << o.shift) != 0); }));
+    res.emplace_back("shr", op([&o] { return static_cast<size_t>((o.a >> o.shift) != 0); }));
+    res.emplace_back("eq", op([&o] { return static_cast<size_t>(o.a == o.b); }));
+    res.emplace_back("less", op([&o] { return static_cast<size_t>(o.a < o.b); }));
+    res.emplace_back("to_string", op([&o] { return to_string(o.a).size(); }));
+    res.emplace_back("from_string", op([&o] { return static_cast<size_t>(T(o.decimal) != 0); }));
+    return res;
+}
+
+void print(options const& opt, std::vector<result> const& results) {
+    if (opt.json) {
+        std::cout << "[\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            result const& r = results[i];
+            std::cout << "  {\"impl\": \"" << IMPL << "\", \"op\": \"" << r.op << "\", \"limbs\": " << r.limbs
+                      << ", \"ns_per_op\": " << r.ns << ", \"gmp_ns_per_op\": " << r.gmp_ns
+                      << ", \"ratio_to_gmp\": " << r.ns / r.gmp_ns << "}" << (i + 1 < results.size() ? "," : "")
+                      << '\n';
+        }
+        std::cout << "]\n";
+        return;
+    }
+    std::cout << "impl,op,limbs,ns_per_op,gmp_ns_per_op,ratio_to_gmp\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        result const& r = results[i];
+        std::cout << IMPL << ',' << r.op << ',' << r.limbs << ',' << r.ns << ',' << r.gmp_ns << ','
+                  << r.ns / r.gmp_ns << '\n';
+    }
+}
+}
+
+int main(int argc, char** argv) {
+    options opt;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            opt.json = true;
+        } else if (std::strcmp(argv[i], "--max-limbs") == 0 && i + 1 < argc) {
+            opt.max_limbs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc) {
+            opt.budget_ns = std::strtod(argv[++i], nullptr) * 1e6;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--json] [--max-limbs N] [--budget-ms MS]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(2020);
+    std::vector<result> results;
+    std::vector<std::string> too_slow;
+    auto skipped = [&too_slow](std::string const& name) {
+        return std::find(too_slow.begin(), too_slow.end(), name) != too_slow.end();
+    };
+    for (size_t limbs = 1; limbs <= opt.max_limbs; limbs *= 10) {
+        auto setup_start = std::chrono::steady_clock::now();
+        operands<big_integer> o;
+        o.a = make_operand(limbs, rng);
+        o.b = make_operand(limbs, rng) + 1;
+        o.wide = make_operand(2 * limbs, rng);
+        o.small = big_integer(static_cast<int>(rng() % 1000000 + 3));
+        o.shift = static_cast<int>(16 * limbs + 5);
+        double setup_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - setup_start).count();
+        // parsing needs a printed operand, so it stops being measured together with printing
+        if (skipped("to_string") && !skipped("from_string")) {
+            too_slow.push_back("from_string");
+        }
+        if (!skipped("from_string")) {
+            o.decimal = to_string(o.a);
+        }
+
+        operands<big_integer_gmp> g;
+        g.a = make_gmp_operand(limbs, rng);
+        g.b = make_gmp_operand(limbs, rng) + 1;
+        g.wide = make_gmp_operand(2 * limbs, rng);
+        g.small = big_integer_gmp(static_cast<int>(rng() % 1000000 + 3));
+        g.shift = o.shift;
+        if (!skipped("from_string")) {
+            g.decimal = to_string(g.a);
+        }
+
+        auto ops = operations(o);
+        auto gmp_ops = operations(g);
+        for (size_t i = 0; i < ops.size(); i++) {
+            std::string name = ops[i].first;
+            if (skipped(name)) {
+                continue;
+            }
+            result r;
+            r.op = name;
+            r.limbs = limbs;
+            r.ns = measure(ops[i].second, opt.budget_ns);
+            r.gmp_ns = measure(gmp_ops[i].second, opt.budget_ns);
+            results.push_back(r);
+            if (r.ns > opt.budget_ns) {
+                too_slow.push_back(name);
+            }
+        }
+        if (setup_ns > 20 * opt.budget_ns) {
+            break;
+        }
+    }
+    print(opt, results);
+    return 0;
+}
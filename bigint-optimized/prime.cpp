@@ -0,0 +1,257 @@
+#include "prime.h"
+
+#include <stdexcept>
+
+bool miller_rabin(montgomery_context const& ctx, std::vector<uint32_t> const& bases);
+
+namespace {
+const uint32_t SIEVE_LIMIT = 2048;
+
+// Small primes split into groups whose product fits in a limb, so that one
+// pass of mod_small over the candidate serves every prime of the group.
+struct small_prime_sieve {
+    std::vector<uint32_t> primes;
+    std::vector<uint32_t> products;
+    std::vector<size_t> group_end;
+
+    small_prime_sieve() {
+        std::vector<bool> composite(SIEVE_LIMIT, false);
+        for (uint32_t i = 2; i < SIEVE_LIMIT; i++) {
+            if (composite[i]) {
+                continue;
+            }
+            primes.push_back(i);
+            for (uint32_t j = i * i; j < SIEVE_LIMIT; j += i) {
+                composite[j] = true;
+            }
+        }
+        uint64_t product = 1;
+        for (size_t i = 0; i < primes.size(); i++) {
+            if (product * primes[i] > UINT32_MAX) {
+                products.push_back(static_cast<uint32_t>(product));
+                group_end.push_back(i);
+                product = 1;
+            }
+            product *= primes[i];
+        }
+        products.push_back(static_cast<uint32_t>(product));
+        group_end.push_back(primes.size());
+    }
+};
+
+small_prime_sieve const& get_sieve() {
+    static const small_prime_sieve sieve;
+    return sieve;
+}
+
+bool is_one_limb(big_integer const& n, uint32_t val) {
+    return n == big_integer(val);
+}
+
+// 0 - composite, 1 - prime, 2 - no small factor found
+int trial_division(big_integer const& n, small_prime_sieve const& sieve) {
+    if (n < 2) {
+        return 0;
+    }
+    size_t begin = 0;
+    for (size_t g = 0; g < sieve.products.size(); g++) {
+        uint32_t rest = mod_small(n, sieve.products[g]);
+        for (size_t i = begin; i < sieve.group_end[g]; i++) {
+            if (rest % sieve.primes[i] == 0) {
+                return is_one_limb(n, sieve.primes[i]) ? 1 : 0;
+            }
+        }
+        begin = sieve.group_end[g];
+    }
+    if (n < big_integer(SIEVE_LIMIT * SIEVE_LIMIT)) {
+        return 1;
+    }
+    return 2;
+}
+
+std::vector<uint32_t> first_bases(small_prime_sieve const& sieve, int rounds) {
+    size_t count = std::min(static_cast<size_t>(std::max(rounds, 0)), sieve.primes.size());
+    return std::vector<uint32_t>(sieve.primes.begin(), sieve.primes.begin() + count);
+}
+
+bool test_candidate(big_integer const& n, std::vector<uint32_t> const& bases, small_prime_sieve const& sieve) {
+    int trial = trial_division(n, sieve);
+    if (trial != 2) {
+        return trial == 1;
+    }
+    return miller_rabin(montgomery_context(n), bases);
+}
+}
+
+uint32_t mod_small(big_integer const& a, uint32_t m) {
+    uint64_t rest = 0;
+    for (size_t i = a.size(); i > 0; i--) {
+        rest = ((rest << 32) | a[i - 1]) % m;
+    }
+    return static_cast<uint32_t>(rest);
+}
+
+montgomery_context::montgomery_context(big_integer const& modulus) : n(modulus), k(modulus.size()) {
+    if (n < 3 || mod_small(n, 2) == 0) {
+        throw std::invalid_argument("montgomery modulus must be odd and greater than one");
+    }
+    n_limbs = load(n);
+    uint32_t inv = n_limbs[0];
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - n_limbs[0] * inv;
+    }
+    n_inv = -inv;
+    big_integer r = (big_integer(1) << static_cast<int>(32 * k)) % n;
+    one = load(r);
+    r2 = load(r * r % n);
+}
+
+big_integer const& montgomery_context::modulus() const {
+    return n;
+}
+
+big_integer montgomery_context::to_montgomery(big_integer const& a) const {
+    limbs res, tmp;
+    mul(res, load(a < n ? a : a % n), r2, tmp);
+    return store(res);
+}
+
+big_integer montgomery_context::from_montgomery(big_integer const& a) const {
+    limbs unit(k, 0);
+    unit[0] = 1;
+    limbs res, tmp;
+    mul(res, load(a), unit, tmp);
+    return store(res);
+}
+
+big_integer montgomery_context::pow(big_integer const& base, big_integer const& exp) const {
+    limbs exp_limbs(exp.size());
+    for (size_t i = 0; i < exp.size(); i++) {
+        exp_limbs[i] = exp[i];
+    }
+    size_t exp_bits = 32 * exp.size();
+    while (exp_bits > 0 && ((exp_limbs[(exp_bits - 1) / 32] >> ((exp_bits - 1) % 32)) & 1) == 0) {
+        exp_bits--;
+    }
+    limbs res, tmp;
+    pow(res, load(to_montgomery(base)), exp_limbs, exp_bits, tmp);
+    return from_montgomery(store(res));
+}
+
+montgomery_context::limbs montgomery_context::load(big_integer const& a) const {
+    limbs res(k, 0);
+    for (size_t i = 0; i < a.size() && i < k; i++) {
+        res[i] = a[i];
+    }
+    return res;
+}
+
+big_integer montgomery_context::store(limbs const& a) const {
+    big_integer res;
+    res.value.resize(k);
+    for (size_t i = 0; i < k; i++) {
+        res.value[i] = a[i];
+    }
+    res.delete_zero();
+    return res;
+}
+
+void montgomery_context::mul(limbs& res, limbs const& a, limbs const& b, limbs& tmp) const {
+    // Coarsely Integrated Operand Scanning, see Koc, Acar, Kaliski:
+    // Analyzing and Comparing Montgomery Multiplication Algorithms
+    tmp.assign(k + 2, 0);
+    for (size_t i = 0; i < k; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < k; j++) {
+            uint64_t curr = tmp[j] + static_cast<uint64_t>(a[j]) * b[i] + carry;
+            tmp[j] = static_cast<uint32_t>(curr);
+            carry = curr >> 32;
+        }
+        uint64_t curr = tmp[k] + carry;
+        tmp[k] = static_cast<uint32_t>(curr);
+        tmp[k + 1] = static_cast<uint32_t>(curr >> 32);
+
+        uint32_t m = tmp[0] * n_inv;
+        carry = (tmp[0] + static_cast<uint64_t>(m) * n_limbs[0]) >> 32;
+        for (size_t j = 1; j < k; j++) {
+            curr = tmp[j] + static_cast<uint64_t>(m) * n_limbs[j] + carry;
+            tmp[j - 1] = static_cast<uint32_t>(curr);
+            carry = curr >> 32;
+        }
+        curr = tmp[k] + carry;
+        tmp[k - 1] = static_cast<uint32_t>(curr);
+        tmp[k] = tmp[k + 1] + static_cast<uint32_t>(curr >> 32);
+    }
+    bool reduce = tmp[k] != 0;
+    if (!reduce) {
+        reduce = true;
+        for (size_t i = k; i > 0; i--) {
+            if (tmp[i - 1] != n_limbs[i - 1]) {
+                reduce = tmp[i - 1] > n_limbs[i - 1];
+                break;
+            }
+        }
+    }
+    res.resize(k);
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < k; i++) {
+        uint64_t diff = static_cast<uint64_t>(tmp[i]) - (reduce ? n_limbs[i] : 0) - borrow;
+        res[i] = static_cast<uint32_t>(diff);
+        borrow = (diff >> 32) != 0;
+    }
+}
+
+void montgomery_context::pow(limbs& res, limbs const& base, limbs const& exp, size_t exp_bits, limbs& tmp) const {
+    res = one;
+    for (size_t i = exp_bits; i > 0; i--) {
+        mul(res, res, res, tmp);
+        if ((exp[(i - 1) / 32] >> ((i - 1) % 32)) & 1) {
+            mul(res, res, base, tmp);
+        }
+    }
+}
+
+bool miller_rabin(montgomery_context const& ctx, std::vector<uint32_t> const& bases) {
+    big_integer n_minus_one = ctx.n - 1;
+    montgomery_context::limbs n_minus_one_limbs = ctx.load(n_minus_one);
+    size_t s = 0;
+    while (((n_minus_one_limbs[s / 32] >> (s % 32)) & 1) == 0) {
+        s++;
+    }
+    big_integer d = n_minus_one >> static_cast<int>(s);
+    montgomery_context::limbs d_limbs = ctx.load(d);
+    size_t d_bits = 32 * ctx.k;
+    while (((d_limbs[(d_bits - 1) / 32] >> ((d_bits - 1) % 32)) & 1) == 0) {
+        d_bits--;
+    }
+    montgomery_context::limbs minus_one = ctx.load(ctx.n - ctx.store(ctx.one));
+    montgomery_context::limbs x, tmp;
+    for (size_t b = 0; b < bases.size(); b++) {
+        big_integer base = big_integer(bases[b]) % ctx.n;
+        if (base == 0) {
+            continue;
+        }
+        ctx.pow(x, ctx.load(ctx.to_montgomery(base)), d_limbs, d_bits, tmp);
+        if (x == ctx.one || x == minus_one) {
+            continue;
+        }
+        bool witness = true;
+        for (size_t i = 1; i < s && witness; i++) {
+            ctx.mul(x, x, x, tmp);
+            if (x == minus_one) {
+                witness = false;
+            } else if (x == ctx.one) {
+                break;
+            }
+        }
+        if (witness) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool is_probable_prime(big_integer const& n, int rounds) {
+    small_prime_sieve const& sieve = get_sieve();
+    return test_candidate(n, first_bases(sieve, rounds), sieve);
+}
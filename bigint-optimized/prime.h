@@ -0,0 +1,44 @@
+#ifndef BIGINT_PRIME_H
+#define BIGINT_PRIME_H
+
+#include <vector>
+#include "big_integer.h"
+
+// Remainder of |a| modulo a single limb, computed in one pass without allocation.
+uint32_t mod_small(big_integer const& a, uint32_t m);
+
+// Arithmetic modulo an odd n > 1 in Montgomery form, R = 2^(32 * k) for a k-limb modulus.
+struct montgomery_context {
+    explicit montgomery_context(big_integer const& modulus);
+
+    big_integer const& modulus() const;
+
+    big_integer to_montgomery(big_integer const& a) const;
+    big_integer from_montgomery(big_integer const& a) const;
+
+    // base^exp mod n for 0 <= base, exp; base and result are in the ordinary form.
+    big_integer pow(big_integer const& base, big_integer const& exp) const;
+
+private:
+    friend bool miller_rabin(montgomery_context const& ctx, std::vector<uint32_t> const& bases);
+
+    typedef std::vector<uint32_t> limbs;
+
+    limbs load(big_integer const& a) const;
+    big_integer store(limbs const& a) const;
+    void mul(limbs& res, limbs const& a, limbs const& b, limbs& tmp) const;
+    void pow(limbs& res, limbs const& base, limbs const& exp, size_t exp_bits, limbs& tmp) const;
+
+    big_integer n;
+    size_t k;
+    limbs n_limbs;
+    uint32_t n_inv;
+    limbs one;
+    limbs r2;
+};
+
+// Trial division by small primes followed by `rounds` Miller-Rabin rounds
+// with the smallest prime bases. Negative numbers are never prime.
+bool is_probable_prime(big_integer const& n, int rounds = 25);
+
+#endif //BIGINT_PRIME_H
@@ -0,0 +1,25 @@
+#ifndef BIGINT_PROBES_H
+#define BIGINT_PROBES_H
+
+// Static tracepoints (USDT) of provider "bigint", compiled in only with
+// BIGINT_USDT and <sys/sdt.h> from systemtap. A probe costs a nop and the
+// loads of its arguments, which are all plain sizes:
+//
+//   bpftrace -e 'usdt:./big_integer_testing:bigint:mul__entry { @[arg0, arg1] = count(); }'
+//
+// Probes, with limb counts as arguments (conversions are the decimal ones):
+//   mul__entry(a, b)          mul__return(result)
+//   div__entry(a, b)          div__return(quotient)
+//   to_string__entry(a)       to_string__return(decimal chunks)
+//   from_string__entry(chars) from_string__return(result)
+//   unshare__entry(limbs)     unshare__return(limbs)   copy-on-write deep copy
+#ifdef BIGINT_USDT
+#include <sys/sdt.h>
+#define BIGINT_PROBE1(name, a) DTRACE_PROBE1(bigint, name, a)
+#define BIGINT_PROBE2(name, a, b) DTRACE_PROBE2(bigint, name, a, b)
+#else
+#define BIGINT_PROBE1(name, a) do {} while (false)
+#define BIGINT_PROBE2(name, a, b) do {} while (false)
+#endif
+
+#endif //BIGINT_PROBES_H
@@ -0,0 +1,80 @@
+// Cost of the long_buf reference counting mode this binary was built with;
+// CMake builds it both with and without BIGINT_ATOMIC_REFCOUNT.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "big_integer.h"
+
+namespace {
+char const* mode() {
+    return long_buf::atomic_refcount ? "atomic" : "plain";
+}
+
+template <typename F>
+void run(char const* name, size_t ops, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    size_t checksum = f();
+    auto finish = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count() / ops;
+    std::cout << mode() << ',' << name << ',' << ns << ',' << checksum << '\n';
+}
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(2020);
+    std::vector<big_integer> values = big_integer::random_n(64, 32 * 16, rng);
+
+    std::cout << "refcount,workload,ns_per_op,checksum\n";
+    run("copy_destroy", count, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            big_integer copy = values[i % values.size()];
+            sum += (copy != 0);
+        }
+        return sum;
+    });
+    run("copy_modify", count, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            big_integer copy = values[i % values.size()];
+            copy += 1;
+            sum += (copy != 0);
+        }
+        return sum;
+    });
+    run("add", count, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i + 1 < count; i++) {
+            sum += (values[i % values.size()] + values[(i + 1) % values.size()] != 0);
+        }
+        return sum;
+    });
+    if (long_buf::atomic_refcount) {
+        size_t threads = std::max(2u, std::thread::hardware_concurrency());
+        run("shared_copy_destroy_mt", count, [&] {
+            std::vector<std::thread> workers;
+            std::vector<size_t> sums(threads, 0);
+            for (size_t t = 0; t < threads; t++) {
+                workers.emplace_back([&, t] {
+                    for (size_t i = t; i < count; i += threads) {
+                        big_integer copy = values[0];
+                        sums[t] += (copy != 0);
+                    }
+                });
+            }
+            size_t sum = 0;
+            for (size_t t = 0; t < threads; t++) {
+                workers[t].join();
+                sum += sums[t];
+            }
+            return sum;
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "serialization.h"
+
+namespace {
+size_t varint_size(uint64_t val) {
+    size_t res = 1;
+    while (val >= 0x80) {
+        val >>= 7;
+        res++;
+    }
+    return res;
+}
+}
+
+size_t serialized_size(big_integer const& a) {
+    size_t limbs = (a.size() == 1 && a[0] == 0) ? 0 : a.size();
+    return varint_size(static_cast<uint64_t>(limbs) << 1) + 4 * limbs;
+}
+
+size_t serialize(big_integer const& a, uint8_t* out) {
+    size_t limbs = (a.size() == 1 && a[0] == 0) ? 0 : a.size();
+    uint64_t header = (static_cast<uint64_t>(limbs) << 1) | (a.sign ? 1 : 0);
+    uint8_t* pos = out;
+    while (header >= 0x80) {
+        *pos++ = static_cast<uint8_t>(header | 0x80);
+        header >>= 7;
+    }
+    *pos++ = static_cast<uint8_t>(header);
+    for (size_t i = 0; i < limbs; i++) {
+        uint32_t limb = a[i];
+        pos[0] = static_cast<uint8_t>(limb);
+        pos[1] = static_cast<uint8_t>(limb >> 8);
+        pos[2] = static_cast<uint8_t>(limb >> 16);
+        pos[3] = static_cast<uint8_t>(limb >> 24);
+        pos += 4;
+    }
+    return pos - out;
+}
+
+std::vector<uint8_t> serialize(big_integer const& a) {
+    std::vector<uint8_t> res(serialized_size(a));
+    serialize(a, res.data());
+    return res;
+}
+
+big_integer deserialize(uint8_t const* data, size_t size, size_t* consumed) {
+    uint64_t header = 0;
+    size_t pos = 0;
+    for (int shift = 0;; shift += 7) {
+        if (pos == size || shift > 63) {
+            throw std::invalid_argument("malformed big_integer header");
+        }
+        uint8_t byte = data[pos++];
+        if (shift == 63 && (byte & 0x7e) != 0) {
+            throw std::invalid_argument("big_integer header overflows 64 bits");
+        }
+        header |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+    uint64_t limbs = header >> 1;
+    if (limbs > (size - pos) / 4) {
+        throw std::invalid_argument("truncated big_integer limbs");
+    }
+    big_integer res;
+    if (limbs != 0) {
+        res.value.resize_uninitialized(limbs);
+        uint32_t* r = res.value.mutable_limbs();
+        for (size_t i = 0; i < limbs; i++) {
+            uint8_t const* p = data + pos + 4 * i;
+            r[i] = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+    }
+    res.delete_zero();
+    res.sign = (header & 1) && !(res.size() == 1 && res[0] == 0);
+    if (consumed != nullptr) {
+        *consumed = pos + 4 * limbs;
+    }
+    return res;
+}
+
+big_integer deserialize(std::vector<uint8_t> const& data) {
+    return deserialize(data.data(), data.size());
+}
+
+std::vector<uint8_t> serialize_n(std::vector<big_integer> const& values) {
+    size_t total = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        total += serialized_size(values[i]);
+    }
+    std::vector<uint8_t> res(total);
+    serialize_n(values.data(), values.size(), res.data());
+    return res;
+}
+
+size_t serialize_n(big_integer const* values, size_t count, uint8_t* out) {
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++) {
+        written += serialize(values[i], out + written);
+    }
+    return written;
+}
+
+std::vector<big_integer> deserialize_n(uint8_t const* data, size_t size) {
+    std::vector<big_integer> res;
+    size_t pos = 0;
+    while (pos < size) {
+        size_t consumed;
+        res.push_back(deserialize(data + pos, size - pos, &consumed));
+        pos += consumed;
+    }
+    return res;
+}
@@ -0,0 +1,28 @@
+#ifndef BIGINT_SERIALIZATION_H
+#define BIGINT_SERIALIZATION_H
+
+#include <cstdint>
+#include <vector>
+#include "big_integer.h"
+
+// Binary format: LEB128 varint of (limb_count << 1 | sign) followed by
+// limb_count 32-bit little-endian limbs, least significant first.
+// Zero is encoded with no limbs, i.e. as the single byte 0x00.
+
+size_t serialized_size(big_integer const& a);
+
+// Writes serialized_size(a) bytes to out and returns their number.
+size_t serialize(big_integer const& a, uint8_t* out);
+std::vector<uint8_t> serialize(big_integer const& a);
+
+// Reads one value from [data, data + size); throws std::invalid_argument
+// on truncated or malformed input. The number of bytes read goes to consumed.
+big_integer deserialize(uint8_t const* data, size_t size, size_t* consumed = nullptr);
+big_integer deserialize(std::vector<uint8_t> const& data);
+
+// Concatenated encodings of all values, written with a single allocation.
+std::vector<uint8_t> serialize_n(std::vector<big_integer> const& values);
+size_t serialize_n(big_integer const* values, size_t count, uint8_t* out);
+std::vector<big_integer> deserialize_n(uint8_t const* data, size_t size);
+
+#endif //BIGINT_SERIALIZATION_H
@@ -0,0 +1,74 @@
+#include "tuning.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+const size_t MIN_KARATSUBA = 4;
+
+big_integer_tuning load_tuning() {
+    big_integer_tuning res = default_tuning();
+    char const* path = std::getenv("BIGINT_TUNING_FILE");
+    if (path == nullptr) {
+        return res;
+    }
+    std::ifstream in(path);
+    if (in) {
+        read_tuning(in, res);
+    }
+    return res;
+}
+
+big_integer_tuning& tuning_slot() {
+    static big_integer_tuning tuning = load_tuning();
+    return tuning;
+}
+}
+
+big_integer_tuning default_tuning() {
+    big_integer_tuning res;
+    res.mul_karatsuba = 48;
+    return res;
+}
+
+big_integer_tuning const& current_tuning() {
+    return tuning_slot();
+}
+
+void set_tuning(big_integer_tuning const& tuning) {
+    tuning_slot() = tuning;
+    if (tuning_slot().mul_karatsuba < MIN_KARATSUBA) {
+        tuning_slot().mul_karatsuba = MIN_KARATSUBA;
+    }
+}
+
+bool read_tuning(std::istream& in, big_integer_tuning& tuning) {
+    big_integer_tuning res = tuning;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name) || name[0] == '#') {
+            continue;
+        }
+        size_t value;
+        std::string rest;
+        if (!(fields >> value) || fields >> rest) {
+            return false;
+        }
+        if (name == "mul_karatsuba") {
+            if (value < MIN_KARATSUBA) {
+                return false;
+            }
+            res.mul_karatsuba = value;
+        }
+    }
+    tuning = res;
+    return true;
+}
+
+void write_tuning(std::ostream& out, big_integer_tuning const& tuning) {
+    out << "mul_karatsuba " << tuning.mul_karatsuba << '\n';
+}
@@ -0,0 +1,29 @@
+#ifndef BIGINT_TUNING_H
+#define BIGINT_TUNING_H
+
+#include <cstddef>
+#include <iosfwd>
+
+// Operand sizes, in limbs, at which big_integer switches algorithms.
+// The bigint_tune tool measures them on the host and writes a tuning file of
+// "name value" lines; big_integer reads the file named by the environment
+// variable BIGINT_TUNING_FILE on first use and keeps the defaults for
+// everything the file does not set.
+struct big_integer_tuning {
+    // shorter operand size from which multiplication uses Karatsuba, at least 4
+    size_t mul_karatsuba;
+};
+
+big_integer_tuning default_tuning();
+
+big_integer_tuning const& current_tuning();
+
+// Replaces the tuning of the whole process; must not race with arithmetic in other threads.
+void set_tuning(big_integer_tuning const& tuning);
+
+// Overwrites the fields found in `in`, returns false on a malformed line or value.
+// Unknown names are skipped, so files of newer versions stay readable.
+bool read_tuning(std::istream& in, big_integer_tuning& tuning);
+void write_tuning(std::ostream& out, big_integer_tuning const& tuning);
+
+#endif //BIGINT_TUNING_H
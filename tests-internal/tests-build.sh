@@ -1,7 +1,8 @@
 #!/bin/bash
 
-mkdir cmake-build-$1
-cd cmake-build-$1
-cmake .. -DCMAKE_BUILD_TYPE=$1
+# tests-build.sh <build type> <target> [build dir suffix] [cmake options...]
+mkdir cmake-build-$1$3
+cd cmake-build-$1$3
+cmake .. -DCMAKE_BUILD_TYPE=$1 "${@:4}"
 make
 ./$2
@@ -1,4 +1,5 @@
 #!/bin/bash
 
-cd cmake-build-Release
+# tests-valgrind.sh <target> [build dir suffix], runs the Release build
+cd cmake-build-Release$2
 valgrind --tool=memcheck --gen-suppressions=all --leak-check=full --leak-resolution=med --track-origins=yes --vgdb=no --error-exitcode=1 ./$1